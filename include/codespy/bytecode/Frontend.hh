@@ -1,6 +1,8 @@
 #pragma once
 
 #include <codespy/bytecode/Visitor.hh>
+#include <codespy/container/HashMap.hh>
+#include <codespy/container/SmallVector.hh>
 #include <codespy/container/Vector.hh>
 #include <codespy/support/String.hh>
 #include <codespy/support/UniquePtr.hh>
@@ -24,7 +26,7 @@ class Value;
 namespace codespy::bc {
 
 class Frontend : public ClassVisitor, public CodeVisitor {
-    using Stack = Vector<ir::Value *, std::uint16_t>;
+    using Stack = SmallVector<ir::Value *, 8, std::uint16_t>;
     struct BlockInfo {
         ir::BasicBlock *block{nullptr};
         Stack entry_stack;
@@ -48,9 +50,9 @@ private:
     ir::Function *m_function;
     ir::BasicBlock *m_block;
     // TODO: Some kind of sparse storage.
-    std::unordered_map<std::int32_t, BlockInfo> m_block_map;
+    HashMap<std::int32_t, BlockInfo> m_block_map;
     // TODO: Can probably be a vector.
-    std::unordered_map<std::uint16_t, ir::Value *> m_local_map;
+    HashMap<std::uint16_t, ir::Value *> m_local_map;
     Vector<ExceptionRange> m_exception_ranges;
     std::deque<std::int32_t> m_queue;
     Stack m_stack;
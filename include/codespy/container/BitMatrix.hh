@@ -0,0 +1,101 @@
+#pragma once
+
+#include <codespy/container/Vector.hh>
+#include <codespy/support/Span.hh>
+
+#include <bit>
+#include <cassert>
+#include <cstdint>
+
+namespace codespy {
+
+// A fixed number of equally sized bit rows, packed contiguously so that iterating over every row stays in cache. Bits
+// past the column count are always kept clear.
+class BitMatrix {
+public:
+    using WordType = std::uint64_t;
+    static constexpr std::uint32_t k_word_bits = sizeof(WordType) * 8;
+
+private:
+    Vector<WordType> m_words;
+    std::uint32_t m_row_count{0};
+    std::uint32_t m_column_count{0};
+    std::uint32_t m_row_words{0};
+
+public:
+    BitMatrix() = default;
+    BitMatrix(std::uint32_t row_count, std::uint32_t column_count)
+        : m_words(row_count * ((column_count + k_word_bits - 1) / k_word_bits)), m_row_count(row_count),
+          m_column_count(column_count), m_row_words((column_count + k_word_bits - 1) / k_word_bits) {}
+    BitMatrix(const BitMatrix &) = delete;
+    BitMatrix(BitMatrix &&) = default;
+    ~BitMatrix() = default;
+
+    BitMatrix &operator=(const BitMatrix &) = delete;
+    BitMatrix &operator=(BitMatrix &&) = default;
+
+    void set(std::uint32_t row, std::uint32_t column);
+    void reset(std::uint32_t row, std::uint32_t column);
+    void clear_row(std::uint32_t row);
+    void fill_row(std::uint32_t row);
+
+    // Returns the index of the first set bit in the row at or after column, or column_count() if none.
+    std::uint32_t find_next(std::uint32_t row, std::uint32_t column) const;
+
+    bool test(std::uint32_t row, std::uint32_t column) const;
+    Span<WordType> row_words(std::uint32_t row) { return {m_words.data() + row * m_row_words, m_row_words}; }
+    Span<const WordType> row_words(std::uint32_t row) const {
+        return {m_words.data() + row * m_row_words, m_row_words};
+    }
+    std::uint32_t row_count() const { return m_row_count; }
+    std::uint32_t column_count() const { return m_column_count; }
+};
+
+inline void BitMatrix::set(std::uint32_t row, std::uint32_t column) {
+    assert(row < m_row_count && column < m_column_count);
+    m_words[row * m_row_words + column / k_word_bits] |= WordType(1) << (column % k_word_bits);
+}
+
+inline void BitMatrix::reset(std::uint32_t row, std::uint32_t column) {
+    assert(row < m_row_count && column < m_column_count);
+    m_words[row * m_row_words + column / k_word_bits] &= ~(WordType(1) << (column % k_word_bits));
+}
+
+inline void BitMatrix::clear_row(std::uint32_t row) {
+    for (auto &word : row_words(row)) {
+        word = 0;
+    }
+}
+
+inline void BitMatrix::fill_row(std::uint32_t row) {
+    auto words = row_words(row);
+    for (auto &word : words) {
+        word = ~WordType(0);
+    }
+    if (const auto tail_bits = m_column_count % k_word_bits; tail_bits != 0) {
+        words[words.size() - 1] = (WordType(1) << tail_bits) - 1;
+    }
+}
+
+inline std::uint32_t BitMatrix::find_next(std::uint32_t row, std::uint32_t column) const {
+    if (column >= m_column_count) {
+        return m_column_count;
+    }
+    const auto words = row_words(row);
+    auto word_index = column / k_word_bits;
+    auto word = words[word_index] & (~WordType(0) << (column % k_word_bits));
+    while (word == 0) {
+        if (++word_index == words.size()) {
+            return m_column_count;
+        }
+        word = words[word_index];
+    }
+    return word_index * k_word_bits + static_cast<std::uint32_t>(std::countr_zero(word));
+}
+
+inline bool BitMatrix::test(std::uint32_t row, std::uint32_t column) const {
+    assert(row < m_row_count && column < m_column_count);
+    return (m_words[row * m_row_words + column / k_word_bits] & (WordType(1) << (column % k_word_bits))) != 0;
+}
+
+} // namespace codespy
@@ -0,0 +1,171 @@
+#pragma once
+
+#include <codespy/container/Vector.hh>
+
+#include <bit>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+
+namespace codespy {
+
+class BitVector {
+    using WordType = std::uint64_t;
+    static constexpr std::uint32_t k_word_bits = sizeof(WordType) * 8;
+
+    Vector<WordType> m_words;
+    std::uint32_t m_size{0};
+
+    static std::uint32_t word_count(std::uint32_t size) { return (size + k_word_bits - 1) / k_word_bits; }
+
+public:
+    BitVector() = default;
+    explicit BitVector(std::uint32_t size) : m_words(word_count(size)), m_size(size) {}
+    BitVector(const BitVector &) = delete;
+    BitVector(BitVector &&) = default;
+    ~BitVector() = default;
+
+    BitVector &operator=(const BitVector &) = delete;
+    BitVector &operator=(BitVector &&) = default;
+
+    void clear_all();
+    void copy_from(const BitVector &other);
+    void ensure_size(std::uint32_t size);
+    void set(std::uint32_t index);
+    void reset(std::uint32_t index);
+    bool test_and_set(std::uint32_t index);
+
+    // Return true if any bit changed.
+    bool union_with(const BitVector &other);
+    bool intersect_with(const BitVector &other);
+    bool subtract(const BitVector &other);
+
+    // Returns the index of the first set bit at or after index, or size() if none.
+    std::uint32_t find_next(std::uint32_t index) const;
+
+    bool test(std::uint32_t index) const;
+    bool any() const;
+    std::uint32_t count() const;
+    bool operator==(const BitVector &other) const;
+    std::uint32_t size() const { return m_size; }
+};
+
+inline void BitVector::clear_all() {
+    for (auto &word : m_words) {
+        word = 0;
+    }
+}
+
+inline void BitVector::copy_from(const BitVector &other) {
+    assert(m_size == other.m_size);
+    for (std::uint32_t i = 0; i < m_words.size(); i++) {
+        m_words[i] = other.m_words[i];
+    }
+}
+
+inline void BitVector::ensure_size(std::uint32_t size) {
+    if (size > m_size) {
+        m_words.ensure_size(word_count(size));
+        m_size = size;
+    }
+}
+
+inline void BitVector::set(std::uint32_t index) {
+    assert(index < m_size);
+    m_words[index / k_word_bits] |= WordType(1) << (index % k_word_bits);
+}
+
+inline void BitVector::reset(std::uint32_t index) {
+    assert(index < m_size);
+    m_words[index / k_word_bits] &= ~(WordType(1) << (index % k_word_bits));
+}
+
+inline bool BitVector::test_and_set(std::uint32_t index) {
+    const bool was_set = test(index);
+    set(index);
+    return was_set;
+}
+
+inline bool BitVector::union_with(const BitVector &other) {
+    assert(m_size == other.m_size);
+    WordType changed = 0;
+    for (std::uint32_t i = 0; i < m_words.size(); i++) {
+        const auto word = m_words[i] | other.m_words[i];
+        changed |= word ^ m_words[i];
+        m_words[i] = word;
+    }
+    return changed != 0;
+}
+
+inline bool BitVector::intersect_with(const BitVector &other) {
+    assert(m_size == other.m_size);
+    WordType changed = 0;
+    for (std::uint32_t i = 0; i < m_words.size(); i++) {
+        const auto word = m_words[i] & other.m_words[i];
+        changed |= word ^ m_words[i];
+        m_words[i] = word;
+    }
+    return changed != 0;
+}
+
+inline bool BitVector::subtract(const BitVector &other) {
+    assert(m_size == other.m_size);
+    WordType changed = 0;
+    for (std::uint32_t i = 0; i < m_words.size(); i++) {
+        const auto word = m_words[i] & ~other.m_words[i];
+        changed |= word ^ m_words[i];
+        m_words[i] = word;
+    }
+    return changed != 0;
+}
+
+inline std::uint32_t BitVector::find_next(std::uint32_t index) const {
+    if (index >= m_size) {
+        return m_size;
+    }
+    auto word_index = index / k_word_bits;
+    auto word = m_words[word_index] & (~WordType(0) << (index % k_word_bits));
+    while (word == 0) {
+        if (++word_index == m_words.size()) {
+            return m_size;
+        }
+        word = m_words[word_index];
+    }
+    return word_index * k_word_bits + static_cast<std::uint32_t>(std::countr_zero(word));
+}
+
+inline bool BitVector::test(std::uint32_t index) const {
+    assert(index < m_size);
+    return (m_words[index / k_word_bits] & (WordType(1) << (index % k_word_bits))) != 0;
+}
+
+inline bool BitVector::any() const {
+    for (auto word : m_words) {
+        if (word != 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+inline std::uint32_t BitVector::count() const {
+    std::uint32_t count = 0;
+    for (auto word : m_words) {
+        count += static_cast<std::uint32_t>(std::popcount(word));
+    }
+    return count;
+}
+
+inline bool BitVector::operator==(const BitVector &other) const {
+    if (m_size != other.m_size) {
+        return false;
+    }
+    for (std::uint32_t i = 0; i < m_words.size(); i++) {
+        if (m_words[i] != other.m_words[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace codespy
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <codespy/container/HashTable.hh>
+
+#include <cassert>
+#include <cstdint>
+#include <functional>
+#include <tuple>
+#include <utility>
+
+namespace codespy {
+
+// A flat hash map, see detail::HashTable. References to entries are invalidated by insertion.
+template <typename K, typename V, typename Hash = codespy::Hash<K>, typename Equal = std::equal_to<K>>
+class HashMap : public detail::HashTable<K, std::pair<K, V>, Hash, Equal> {
+    using Base = detail::HashTable<K, std::pair<K, V>, Hash, Equal>;
+
+public:
+    using typename Base::iterator;
+
+    // Inserts an entry with the value constructed from args if there isn't one for key already. Returns an iterator to
+    // the entry for key and whether it was inserted.
+    template <typename... Args>
+    std::pair<iterator, bool> emplace(const K &key, Args &&...args);
+
+    V &operator[](const K &key) { return emplace(key).first->second; }
+    V &at(const K &key);
+    const V &at(const K &key) const;
+};
+
+template <typename K, typename V, typename Hash, typename Equal>
+template <typename... Args>
+std::pair<typename HashMap<K, V, Hash, Equal>::iterator, bool> HashMap<K, V, Hash, Equal>::emplace(const K &key,
+                                                                                                   Args &&...args) {
+    const auto [index, inserted] = Base::find_or_prepare_insert(key);
+    if (inserted) {
+        new (&Base::slot(index)) std::pair<K, V>(std::piecewise_construct, std::forward_as_tuple(key),
+                                                 std::forward_as_tuple(std::forward<Args>(args)...));
+    }
+    return std::make_pair(Base::iterator_at(index), inserted);
+}
+
+template <typename K, typename V, typename Hash, typename Equal>
+V &HashMap<K, V, Hash, Equal>::at(const K &key) {
+    const auto index = Base::find_index(key);
+    assert(index != Base::k_not_found);
+    return Base::slot(index).second;
+}
+
+template <typename K, typename V, typename Hash, typename Equal>
+const V &HashMap<K, V, Hash, Equal>::at(const K &key) const {
+    const auto index = Base::find_index(key);
+    assert(index != Base::k_not_found);
+    return Base::slot(index).second;
+}
+
+} // namespace codespy
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <codespy/container/HashTable.hh>
+
+#include <functional>
+
+namespace codespy {
+
+// A flat hash set, see detail::HashTable.
+template <typename T, typename Hash = codespy::Hash<T>, typename Equal = std::equal_to<T>>
+class HashSet : public detail::HashTable<T, T, Hash, Equal> {
+    using Base = detail::HashTable<T, T, Hash, Equal>;
+
+public:
+    // Returns true if value wasn't already in the set.
+    bool insert(const T &value);
+};
+
+template <typename T, typename Hash, typename Equal>
+bool HashSet<T, Hash, Equal>::insert(const T &value) {
+    const auto [index, inserted] = Base::find_or_prepare_insert(value);
+    if (inserted) {
+        new (&Base::slot(index)) T(value);
+    }
+    return inserted;
+}
+
+} // namespace codespy
@@ -0,0 +1,376 @@
+#pragma once
+
+#include <codespy/support/Hash.hh>
+
+#include <bit>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <type_traits>
+#include <utility>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace codespy::detail {
+
+// The control bytes of a group of slots, which can all be matched against at once. A control byte is either one of the
+// special negative values below, or the low seven bits of the hash of the key in a full slot.
+class HashGroup {
+public:
+    static constexpr std::uint32_t k_width = 16;
+    static constexpr std::int8_t k_empty = -128;
+    static constexpr std::int8_t k_deleted = -2;
+
+private:
+#ifdef __SSE2__
+    __m128i m_ctrl;
+#else
+    const std::int8_t *m_ctrl;
+
+    template <typename F>
+    std::uint32_t match_each(F predicate) const;
+#endif
+
+public:
+    explicit HashGroup(const std::int8_t *ctrl);
+
+    // Return a mask with bit i set if slot i matches.
+    std::uint32_t match(std::int8_t h2) const;
+    std::uint32_t match_empty() const;
+    std::uint32_t match_empty_or_deleted() const;
+};
+
+// An open addressing hash table in the style of SwissTable. Slots are split into groups of 16, each with a control byte
+// per slot, and keys are probed for a group at a time. The top bits of the hash pick the first group to probe, and the
+// bottom seven are stored in the control byte so that most non-matching slots are skipped without comparing keys.
+// Unlike the node based standard containers, inserting may move entries, so references to them are only stable up
+// until the next insertion. Erasing never moves other entries.
+template <typename K, typename Slot, typename Hash, typename Equal>
+class HashTable {
+    std::int8_t *m_ctrl{nullptr};
+    Slot *m_slots{nullptr};
+    std::uint32_t m_capacity{0};
+    std::uint32_t m_size{0};
+    // Number of empty slots that can still be filled before a rehash is needed. Erased slots only give this back when
+    // they can be marked as empty rather than deleted.
+    std::uint32_t m_growth_left{0};
+
+    static const K &key_of(const Slot &slot) {
+        if constexpr (std::is_same_v<K, Slot>) {
+            return slot;
+        } else {
+            return slot.first;
+        }
+    }
+    static std::uint64_t hash_of(const K &key);
+    static std::uint32_t max_load(std::uint32_t capacity) { return capacity - capacity / 8; }
+
+    template <bool Const>
+    class Iterator {
+        friend HashTable;
+        using TableType = std::conditional_t<Const, const HashTable, HashTable>;
+        TableType *m_table;
+        std::uint32_t m_index;
+
+        Iterator(TableType *table, std::uint32_t index) : m_table(table), m_index(index) { skip_empty(); }
+        void skip_empty() {
+            while (m_index < m_table->m_capacity && m_table->m_ctrl[m_index] < 0) {
+                m_index++;
+            }
+        }
+
+    public:
+        using ValueType = std::conditional_t<Const, const Slot, Slot>;
+
+        Iterator &operator++() {
+            m_index++;
+            skip_empty();
+            return *this;
+        }
+        bool operator==(const Iterator &other) const { return m_index == other.m_index; }
+
+        ValueType &operator*() const { return m_table->m_slots[m_index]; }
+        ValueType *operator->() const { return &m_table->m_slots[m_index]; }
+    };
+
+    void rehash(std::uint32_t capacity);
+    std::uint32_t find_free_slot(std::uint64_t hash) const;
+
+protected:
+    static constexpr std::uint32_t k_not_found = ~0u;
+
+    std::uint32_t find_index(const K &key) const;
+    // Returns the index of the slot for key and whether it needs to be constructed by the caller.
+    std::pair<std::uint32_t, bool> find_or_prepare_insert(const K &key);
+    void erase_index(std::uint32_t index);
+    Slot &slot(std::uint32_t index) const { return m_slots[index]; }
+    Iterator<false> iterator_at(std::uint32_t index) { return {this, index}; }
+
+public:
+    using iterator = Iterator<false>;
+    using const_iterator = Iterator<true>;
+
+    constexpr HashTable() = default;
+    HashTable(const HashTable &) = delete;
+    HashTable(HashTable &&);
+    ~HashTable();
+
+    HashTable &operator=(const HashTable &) = delete;
+    HashTable &operator=(HashTable &&);
+
+    void clear();
+    // Make room for at least size entries in total without rehashing.
+    void ensure_capacity(std::uint32_t size);
+
+    iterator find(const K &key) { return {this, find_or_end(key)}; }
+    const_iterator find(const K &key) const { return {this, find_or_end(key)}; }
+    bool contains(const K &key) const { return find_index(key) != k_not_found; }
+    bool erase(const K &key);
+    void erase(iterator it) { erase_index(it.m_index); }
+
+    iterator begin() { return {this, 0}; }
+    iterator end() { return {this, m_capacity}; }
+    const_iterator begin() const { return {this, 0}; }
+    const_iterator end() const { return {this, m_capacity}; }
+
+    bool empty() const { return m_size == 0; }
+    std::uint32_t capacity() const { return m_capacity; }
+    std::uint32_t size() const { return m_size; }
+
+private:
+    std::uint32_t find_or_end(const K &key) const {
+        const auto index = find_index(key);
+        return index != k_not_found ? index : m_capacity;
+    }
+};
+
+inline HashGroup::HashGroup(const std::int8_t *ctrl) {
+#ifdef __SSE2__
+    m_ctrl = _mm_loadu_si128(reinterpret_cast<const __m128i *>(ctrl));
+#else
+    m_ctrl = ctrl;
+#endif
+}
+
+#ifndef __SSE2__
+template <typename F>
+std::uint32_t HashGroup::match_each(F predicate) const {
+    std::uint32_t mask = 0;
+    for (std::uint32_t i = 0; i < k_width; i++) {
+        if (predicate(m_ctrl[i])) {
+            mask |= 1u << i;
+        }
+    }
+    return mask;
+}
+#endif
+
+inline std::uint32_t HashGroup::match(std::int8_t h2) const {
+#ifdef __SSE2__
+    return static_cast<std::uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(m_ctrl, _mm_set1_epi8(h2))));
+#else
+    return match_each([h2](std::int8_t ctrl) {
+        return ctrl == h2;
+    });
+#endif
+}
+
+inline std::uint32_t HashGroup::match_empty() const {
+#ifdef __SSE2__
+    return static_cast<std::uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(m_ctrl, _mm_set1_epi8(k_empty))));
+#else
+    return match_each([](std::int8_t ctrl) {
+        return ctrl == k_empty;
+    });
+#endif
+}
+
+inline std::uint32_t HashGroup::match_empty_or_deleted() const {
+#ifdef __SSE2__
+    // Both special values are negative, and full slots never are.
+    return static_cast<std::uint32_t>(_mm_movemask_epi8(m_ctrl));
+#else
+    return match_each([](std::int8_t ctrl) {
+        return ctrl < 0;
+    });
+#endif
+}
+
+template <typename K, typename Slot, typename Hash, typename Equal>
+HashTable<K, Slot, Hash, Equal>::HashTable(HashTable &&other)
+    : m_ctrl(std::exchange(other.m_ctrl, nullptr)), m_slots(std::exchange(other.m_slots, nullptr)),
+      m_capacity(std::exchange(other.m_capacity, 0u)), m_size(std::exchange(other.m_size, 0u)),
+      m_growth_left(std::exchange(other.m_growth_left, 0u)) {}
+
+template <typename K, typename Slot, typename Hash, typename Equal>
+HashTable<K, Slot, Hash, Equal>::~HashTable() {
+    clear();
+}
+
+template <typename K, typename Slot, typename Hash, typename Equal>
+HashTable<K, Slot, Hash, Equal> &HashTable<K, Slot, Hash, Equal>::operator=(HashTable &&other) {
+    if (this != &other) {
+        clear();
+        m_ctrl = std::exchange(other.m_ctrl, nullptr);
+        m_slots = std::exchange(other.m_slots, nullptr);
+        m_capacity = std::exchange(other.m_capacity, 0u);
+        m_size = std::exchange(other.m_size, 0u);
+        m_growth_left = std::exchange(other.m_growth_left, 0u);
+    }
+    return *this;
+}
+
+template <typename K, typename Slot, typename Hash, typename Equal>
+std::uint64_t HashTable<K, Slot, Hash, Equal>::hash_of(const K &key) {
+    auto hash = static_cast<std::uint64_t>(Hash{}(key));
+    if constexpr (!requires { typename Hash::is_avalanching; }) {
+        // Mix the hash since e.g. the standard ones for integers and pointers are the identity, whereas both the top
+        // and bottom bits are used here.
+        hash ^= hash >> 33u;
+        hash *= 0xff51afd7ed558ccdu;
+        hash ^= hash >> 33u;
+    }
+    return hash;
+}
+
+template <typename K, typename Slot, typename Hash, typename Equal>
+void HashTable<K, Slot, Hash, Equal>::clear() {
+    if constexpr (!std::is_trivially_destructible_v<Slot>) {
+        for (std::uint32_t i = 0; i < m_capacity; i++) {
+            if (m_ctrl[i] >= 0) {
+                m_slots[i].~Slot();
+            }
+        }
+    }
+    delete[] std::exchange(m_ctrl, nullptr);
+    delete[] reinterpret_cast<std::uint8_t *>(std::exchange(m_slots, nullptr));
+    m_capacity = 0;
+    m_size = 0;
+    m_growth_left = 0;
+}
+
+template <typename K, typename Slot, typename Hash, typename Equal>
+void HashTable<K, Slot, Hash, Equal>::ensure_capacity(std::uint32_t size) {
+    if (size <= max_load(m_capacity)) {
+        return;
+    }
+    // Round up to a power of two number of groups, so that probing eventually visits every group.
+    auto capacity = std::bit_ceil((size + size / 7 + HashGroup::k_width - 1) / HashGroup::k_width);
+    rehash(capacity * HashGroup::k_width);
+}
+
+template <typename K, typename Slot, typename Hash, typename Equal>
+void HashTable<K, Slot, Hash, Equal>::rehash(std::uint32_t capacity) {
+    assert(capacity % HashGroup::k_width == 0 && std::has_single_bit(capacity / HashGroup::k_width));
+    assert(m_size <= max_load(capacity));
+    auto *old_ctrl = std::exchange(m_ctrl, new std::int8_t[capacity]);
+    auto *old_slots = std::exchange(m_slots, reinterpret_cast<Slot *>(new std::uint8_t[capacity * sizeof(Slot)]));
+    const auto old_capacity = std::exchange(m_capacity, capacity);
+    std::memset(m_ctrl, HashGroup::k_empty, capacity);
+    m_growth_left = max_load(capacity) - m_size;
+    for (std::uint32_t i = 0; i < old_capacity; i++) {
+        if (old_ctrl[i] < 0) {
+            continue;
+        }
+        const auto hash = hash_of(key_of(old_slots[i]));
+        const auto index = find_free_slot(hash);
+        m_ctrl[index] = static_cast<std::int8_t>(hash & 0x7fu);
+        new (&m_slots[index]) Slot(std::move(old_slots[i]));
+        old_slots[i].~Slot();
+    }
+    delete[] old_ctrl;
+    delete[] reinterpret_cast<std::uint8_t *>(old_slots);
+}
+
+template <typename K, typename Slot, typename Hash, typename Equal>
+std::uint32_t HashTable<K, Slot, Hash, Equal>::find_free_slot(std::uint64_t hash) const {
+    // Triangular probing over a power of two number of groups visits every group.
+    const auto group_mask = m_capacity / HashGroup::k_width - 1;
+    auto group = static_cast<std::uint32_t>(hash >> 7u) & group_mask;
+    for (std::uint32_t step = 1;; group = (group + step++) & group_mask) {
+        const auto mask = HashGroup(m_ctrl + group * HashGroup::k_width).match_empty_or_deleted();
+        if (mask != 0) {
+            return group * HashGroup::k_width + std::countr_zero(mask);
+        }
+    }
+}
+
+template <typename K, typename Slot, typename Hash, typename Equal>
+std::uint32_t HashTable<K, Slot, Hash, Equal>::find_index(const K &key) const {
+    if (m_size == 0) {
+        return k_not_found;
+    }
+    const auto hash = hash_of(key);
+    const auto h2 = static_cast<std::int8_t>(hash & 0x7fu);
+    const auto group_mask = m_capacity / HashGroup::k_width - 1;
+    auto group = static_cast<std::uint32_t>(hash >> 7u) & group_mask;
+    for (std::uint32_t step = 1;; group = (group + step++) & group_mask) {
+        const HashGroup control(m_ctrl + group * HashGroup::k_width);
+        for (auto mask = control.match(h2); mask != 0; mask &= mask - 1) {
+            const auto index = group * HashGroup::k_width + std::countr_zero(mask);
+            if (Equal{}(key_of(m_slots[index]), key)) {
+                return index;
+            }
+        }
+        // A key is only ever placed past a group if it was full at the time, and erasing from a full group leaves a
+        // deleted marker, so an empty slot ends the probe sequence.
+        if (control.match_empty() != 0) {
+            return k_not_found;
+        }
+    }
+}
+
+template <typename K, typename Slot, typename Hash, typename Equal>
+std::pair<std::uint32_t, bool> HashTable<K, Slot, Hash, Equal>::find_or_prepare_insert(const K &key) {
+    if (const auto index = find_index(key); index != k_not_found) {
+        return std::make_pair(index, false);
+    }
+    if (m_growth_left == 0) {
+        // Reclaim deleted slots in place if they make up a good part of the table, otherwise grow.
+        if (m_capacity != 0 && m_size <= max_load(m_capacity) / 2) {
+            rehash(m_capacity);
+        } else {
+            rehash(m_capacity != 0 ? m_capacity * 2 : HashGroup::k_width);
+        }
+    }
+    const auto hash = hash_of(key);
+    const auto index = find_free_slot(hash);
+    if (m_ctrl[index] == HashGroup::k_empty) {
+        m_growth_left--;
+    }
+    m_ctrl[index] = static_cast<std::int8_t>(hash & 0x7fu);
+    m_size++;
+    return std::make_pair(index, true);
+}
+
+template <typename K, typename Slot, typename Hash, typename Equal>
+void HashTable<K, Slot, Hash, Equal>::erase_index(std::uint32_t index) {
+    assert(index < m_capacity && m_ctrl[index] >= 0);
+    m_slots[index].~Slot();
+    m_size--;
+    // If the group already has an empty slot then no probe sequence passes through it, so the slot can be reused
+    // freely. Otherwise a deleted marker is needed to keep later groups reachable.
+    const auto group_begin = index - index % HashGroup::k_width;
+    if (HashGroup(m_ctrl + group_begin).match_empty() != 0) {
+        m_ctrl[index] = HashGroup::k_empty;
+        m_growth_left++;
+    } else {
+        m_ctrl[index] = HashGroup::k_deleted;
+    }
+}
+
+template <typename K, typename Slot, typename Hash, typename Equal>
+bool HashTable<K, Slot, Hash, Equal>::erase(const K &key) {
+    const auto index = find_index(key);
+    if (index == k_not_found) {
+        return false;
+    }
+    erase_index(index);
+    return true;
+}
+
+} // namespace codespy::detail
@@ -31,8 +31,13 @@ public:
     template <std::derived_from<T> U, typename... Args>
     U *emplace(iterator it, Args &&...args);
     void insert(iterator it, T *elem);
+    // Moves the elements [first, last) of other to before it.
+    void splice(iterator it, List &other, iterator first, iterator last);
+    void splice(iterator it, List &other) { splice(it, other, other.begin(), other.end()); }
     iterator erase(iterator it);
     iterator erase(iterator first, iterator last);
+    // Like erase, but leaves destroying the element to the caller.
+    void unlink(iterator it);
 
     iterator begin() const;
     iterator end() const;
@@ -113,13 +118,30 @@ void List<T>::insert(iterator it, T *elem) {
     prev->m_next = elem;
 }
 
+template <typename T>
+void List<T>::splice(iterator it, List &, iterator first, iterator last) {
+    if (first == last) {
+        return;
+    }
+
+    // Unlink from other.
+    auto *first_elem = first.elem();
+    auto *last_elem = last.elem()->prev();
+    first_elem->m_prev->m_next = last.elem();
+    last.elem()->m_prev = first_elem->m_prev;
+
+    auto *prev = it.elem()->prev();
+    first_elem->m_prev = prev;
+    last_elem->m_next = it.elem();
+    it.elem()->m_prev = last_elem;
+    prev->m_next = first_elem;
+}
+
 template <typename T>
 List<T>::iterator List<T>::erase(iterator it) {
-    auto *prev = it->prev();
-    auto *next = it->next();
-    next->m_prev = prev;
-    prev->m_next = next;
-    ListNodeTraits<T>::destroy_node(*it++);
+    auto *elem = *it++;
+    unlink(iterator(elem));
+    ListNodeTraits<T>::destroy_node(elem);
     return it;
 }
 
@@ -131,6 +153,14 @@ List<T>::iterator List<T>::erase(iterator first, iterator last) {
     return last;
 }
 
+template <typename T>
+void List<T>::unlink(iterator it) {
+    auto *prev = it->prev();
+    auto *next = it->next();
+    next->m_prev = prev;
+    prev->m_next = next;
+}
+
 template <typename T>
 List<T>::iterator List<T>::begin() const {
     return ++end();
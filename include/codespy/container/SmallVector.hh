@@ -0,0 +1,259 @@
+#pragma once
+
+#include <codespy/support/Span.hh>
+#include <codespy/support/Utility.hh>
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <utility>
+
+namespace codespy {
+
+// A Vector with room for N elements inline, so that it only allocates once it grows past that. Moving one that is still
+// inline moves each element across. Unlike Vector, references can't be stored.
+template <typename T, std::size_t N, typename SizeType = std::uint32_t>
+class SmallVector {
+    static_assert(N != 0);
+
+    T *m_data{reinterpret_cast<T *>(m_inline)};
+    SizeType m_capacity{N};
+    SizeType m_size{0};
+    alignas(T) std::uint8_t m_inline[N * sizeof(T)];
+
+    bool is_inline() const { return m_data == reinterpret_cast<const T *>(m_inline); }
+    void destroy_elements();
+    void move_from(SmallVector &other);
+    void reallocate(SizeType capacity);
+
+public:
+    SmallVector() = default;
+    template <typename... Args>
+    explicit SmallVector(SizeType size, Args &&...args);
+    template <typename It>
+    SmallVector(It first, It last);
+    SmallVector(const SmallVector &) = delete;
+    SmallVector(SmallVector &&other) { move_from(other); }
+    ~SmallVector();
+
+    SmallVector &operator=(const SmallVector &) = delete;
+    SmallVector &operator=(SmallVector &&);
+
+    void clear();
+    void ensure_capacity(SizeType capacity);
+    template <typename... Args>
+    void ensure_size(SizeType size, Args &&...args);
+
+    template <typename... Args>
+    T &emplace(Args &&...args);
+    template <typename Container>
+    void extend(const Container &container);
+    void push(const T &elem);
+    void push(T &&elem);
+    void pop();
+
+    Span<T> span() { return {m_data, static_cast<std::size_t>(m_size)}; }
+    Span<const T> span() const { return {m_data, static_cast<std::size_t>(m_size)}; }
+    T take_last();
+
+    T *begin() { return m_data; }
+    T *end() { return m_data + m_size; }
+    const T *begin() const { return m_data; }
+    const T *end() const { return m_data + m_size; }
+
+    T &operator[](SizeType index);
+    const T &operator[](SizeType index) const;
+
+    T &first() { return begin()[0]; }
+    const T &first() const { return begin()[0]; }
+    T &last() { return end()[-1]; }
+    const T &last() const { return end()[-1]; }
+
+    bool empty() const { return m_size == 0; }
+    T *data() const { return m_data; }
+    SizeType capacity() const { return m_capacity; }
+    SizeType size() const { return m_size; }
+    SizeType size_bytes() const { return m_size * sizeof(T); }
+};
+
+template <typename T, std::size_t N, typename SizeType>
+template <typename... Args>
+SmallVector<T, N, SizeType>::SmallVector(SizeType size, Args &&...args) {
+    ensure_size(size, std::forward<Args>(args)...);
+}
+
+template <typename T, std::size_t N, typename SizeType>
+template <typename It>
+SmallVector<T, N, SizeType>::SmallVector(It first, It last) {
+    for (; first != last; ++first) {
+        emplace(*first);
+    }
+}
+
+template <typename T, std::size_t N, typename SizeType>
+SmallVector<T, N, SizeType>::~SmallVector() {
+    clear();
+}
+
+template <typename T, std::size_t N, typename SizeType>
+SmallVector<T, N, SizeType> &SmallVector<T, N, SizeType>::operator=(SmallVector &&other) {
+    if (this != &other) {
+        clear();
+        move_from(other);
+    }
+    return *this;
+}
+
+template <typename T, std::size_t N, typename SizeType>
+void SmallVector<T, N, SizeType>::destroy_elements() {
+    if constexpr (!std::is_trivially_destructible_v<T>) {
+        for (auto *elem = end(); elem != begin();) {
+            (--elem)->~T();
+        }
+    }
+}
+
+template <typename T, std::size_t N, typename SizeType>
+void SmallVector<T, N, SizeType>::move_from(SmallVector &other) {
+    assert(empty() && is_inline());
+    if (!other.is_inline()) {
+        m_data = std::exchange(other.m_data, reinterpret_cast<T *>(other.m_inline));
+        m_capacity = std::exchange(other.m_capacity, SizeType(N));
+        m_size = std::exchange(other.m_size, SizeType(0));
+        return;
+    }
+    if constexpr (std::is_trivially_copyable_v<T>) {
+        std::memcpy(m_data, other.m_data, other.size_bytes());
+    } else {
+        for (auto *data = m_data; auto &elem : other) {
+            new (data++) T(std::move(elem));
+        }
+        other.destroy_elements();
+    }
+    m_size = std::exchange(other.m_size, SizeType(0));
+}
+
+template <typename T, std::size_t N, typename SizeType>
+void SmallVector<T, N, SizeType>::clear() {
+    destroy_elements();
+    m_size = 0;
+    if (!is_inline()) {
+        delete[] reinterpret_cast<std::uint8_t *>(m_data);
+        m_data = reinterpret_cast<T *>(m_inline);
+        m_capacity = N;
+    }
+}
+
+template <typename T, std::size_t N, typename SizeType>
+void SmallVector<T, N, SizeType>::ensure_capacity(SizeType capacity) {
+    if (capacity > m_capacity) {
+        reallocate(std::max(SizeType(m_capacity * 2 + 1), capacity));
+    }
+}
+
+template <typename T, std::size_t N, typename SizeType>
+template <typename... Args>
+void SmallVector<T, N, SizeType>::ensure_size(SizeType size, Args &&...args) {
+    if (size <= m_size) {
+        return;
+    }
+    ensure_capacity(size);
+    if constexpr (!std::is_trivially_constructible_v<T> || sizeof...(Args) != 0) {
+        for (SizeType i = m_size; i < size; i++) {
+            new (begin() + i) T(std::forward<Args>(args)...);
+        }
+    } else {
+        std::memset(begin() + m_size, 0, size * sizeof(T) - m_size * sizeof(T));
+    }
+    m_size = size;
+}
+
+template <typename T, std::size_t N, typename SizeType>
+void SmallVector<T, N, SizeType>::reallocate(SizeType capacity) {
+    assert(capacity > N && capacity >= m_size);
+    auto *new_data = reinterpret_cast<T *>(new std::uint8_t[capacity * sizeof(T)]);
+    if constexpr (!std::is_trivially_copyable_v<T>) {
+        for (auto *data = new_data; auto &elem : *this) {
+            new (data++) T(std::move(elem));
+        }
+        destroy_elements();
+    } else if (m_size != 0) {
+        std::memcpy(new_data, m_data, size_bytes());
+    }
+    if (!is_inline()) {
+        delete[] reinterpret_cast<std::uint8_t *>(m_data);
+    }
+    m_data = new_data;
+    m_capacity = capacity;
+}
+
+template <typename T, std::size_t N, typename SizeType>
+template <typename... Args>
+T &SmallVector<T, N, SizeType>::emplace(Args &&...args) {
+    ensure_capacity(m_size + 1);
+    new (end()) T(std::forward<Args>(args)...);
+    return (*this)[m_size++];
+}
+
+template <typename T, std::size_t N, typename SizeType>
+template <typename Container>
+void SmallVector<T, N, SizeType>::extend(const Container &container) {
+    if (container.empty()) {
+        return;
+    }
+    ensure_capacity(m_size + container.size());
+    if constexpr (std::is_trivially_copyable_v<T>) {
+        std::memcpy(end(), container.data(), container.size_bytes());
+        m_size += container.size();
+    } else {
+        for (const auto &elem : container) {
+            push(elem);
+        }
+    }
+}
+
+template <typename T, std::size_t N, typename SizeType>
+void SmallVector<T, N, SizeType>::push(const T &elem) {
+    ensure_capacity(m_size + 1);
+    new (end()) T(elem);
+    m_size++;
+}
+
+template <typename T, std::size_t N, typename SizeType>
+void SmallVector<T, N, SizeType>::push(T &&elem) {
+    ensure_capacity(m_size + 1);
+    new (end()) T(std::move(elem));
+    m_size++;
+}
+
+template <typename T, std::size_t N, typename SizeType>
+void SmallVector<T, N, SizeType>::pop() {
+    assert(!empty());
+    m_size--;
+    end()->~T();
+}
+
+template <typename T, std::size_t N, typename SizeType>
+T SmallVector<T, N, SizeType>::take_last() {
+    assert(!empty());
+    m_size--;
+    auto value = std::move(*end());
+    end()->~T();
+    return value;
+}
+
+template <typename T, std::size_t N, typename SizeType>
+T &SmallVector<T, N, SizeType>::operator[](SizeType index) {
+    assert(index < m_size);
+    return begin()[index];
+}
+
+template <typename T, std::size_t N, typename SizeType>
+const T &SmallVector<T, N, SizeType>::operator[](SizeType index) const {
+    assert(index < m_size);
+    return begin()[index];
+}
+
+} // namespace codespy
@@ -3,14 +3,27 @@
 #include <codespy/gui/TreeModel.hh>
 
 #include <QMainWindow>
+#include <QThreadPool>
+
+namespace codespy::ir {
+
+class PassManager;
+
+} // namespace codespy::ir
 
 namespace codespy::gui {
 
 class MainWindow : public QMainWindow {
     Q_OBJECT;
 
+private:
+    const ir::PassManager *m_upgrade_pipeline;
+    // Only ever runs one upgrade at a time since the IR isn't thread safe.
+    QThreadPool m_upgrade_pool;
+
 public:
-    MainWindow(Vector<ClassData> &&classes);
+    // If upgrade_pipeline is given, it is run in the background on the pending methods of a class when it is opened.
+    MainWindow(Vector<ClassData> &&classes, const ir::PassManager *upgrade_pipeline = nullptr);
 };
 
 } // namespace codespy::gui
@@ -4,12 +4,20 @@
 
 #include <QAbstractItemModel>
 
+namespace codespy::ir {
+
+class Function;
+
+} // namespace codespy::ir
+
 namespace codespy::gui {
 
 struct ClassData {
     QString name;
     QString ir_text;
     QString bc_text;
+    // Methods which have only been through the cheap pipeline, to be upgraded when the class is first opened.
+    Vector<ir::Function *> pending_methods;
 };
 
 class TreeModel : public QAbstractItemModel {
@@ -28,6 +36,7 @@ public:
     int rowCount(const QModelIndex &parent) const override;
     int columnCount(const QModelIndex &parent) const override;
 
+    ClassData &class_data(uint32_t index) { return m_classes[index]; }
     const QString &ir_text(uint32_t index) const { return m_classes[index].ir_text; }
     const QString &bc_text(uint32_t index) const { return m_classes[index].bc_text; }
 };
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <codespy/container/Array.hh>
+#include <codespy/support/Enum.hh>
+#include <codespy/support/UniquePtr.hh>
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+namespace codespy::ir {
+
+class AnalysisManager;
+class CfgSnapshot;
+class DominanceInfo;
+class Function;
+class LocalLiveness;
+
+enum class AnalysisKind : std::uint8_t {
+    CfgSnapshot,
+    Dominance,
+    Liveness,
+};
+
+constexpr std::size_t k_analysis_kind_count = 3;
+
+class PreservedAnalyses {
+    std::uint32_t m_mask;
+
+    explicit PreservedAnalyses(std::uint32_t mask) : m_mask(mask) {}
+
+public:
+    static PreservedAnalyses all() { return PreservedAnalyses(~0u); }
+    static PreservedAnalyses none() { return PreservedAnalyses(0u); }
+
+    PreservedAnalyses &preserve(AnalysisKind kind) {
+        m_mask |= 1u << codespy::to_underlying(kind);
+        return *this;
+    }
+    bool is_preserved(AnalysisKind kind) const { return (m_mask & (1u << codespy::to_underlying(kind))) != 0; }
+};
+
+// Specialised for each analysis result type to give its kind and how to compute it.
+template <typename T>
+struct AnalysisTraits;
+
+template <>
+struct AnalysisTraits<CfgSnapshot> {
+    static constexpr auto k_kind = AnalysisKind::CfgSnapshot;
+    static CfgSnapshot compute(AnalysisManager &analyses);
+};
+
+template <>
+struct AnalysisTraits<DominanceInfo> {
+    static constexpr auto k_kind = AnalysisKind::Dominance;
+    static DominanceInfo compute(AnalysisManager &analyses);
+};
+
+template <>
+struct AnalysisTraits<LocalLiveness> {
+    static constexpr auto k_kind = AnalysisKind::Liveness;
+    static LocalLiveness compute(AnalysisManager &analyses);
+};
+
+// Caches analysis results for a single function between passes.
+class AnalysisManager {
+    struct ResultBase {
+        virtual ~ResultBase() = default;
+    };
+
+    template <typename T>
+    struct Result final : ResultBase {
+        T value;
+
+        explicit Result(T &&value) : value(std::move(value)) {}
+    };
+
+    Function *const m_function;
+    Array<UniquePtr<ResultBase>, k_analysis_kind_count> m_results{};
+
+public:
+    explicit AnalysisManager(Function *function) : m_function(function) {}
+
+    // Returns the result of the analysis, computing it if it isn't already cached.
+    template <typename T>
+    T &get();
+
+    // Returns the result of the analysis if it's cached, or nullptr otherwise.
+    template <typename T>
+    T *get_cached() const;
+
+    // Drops any cached results which weren't preserved, along with liveness if the CFG snapshot it refers to is dropped.
+    void invalidate(PreservedAnalyses preserved);
+
+    Function *function() const { return m_function; }
+};
+
+template <typename T>
+T &AnalysisManager::get() {
+    auto &slot = m_results[codespy::to_underlying(AnalysisTraits<T>::k_kind)];
+    if (!slot) {
+        slot = codespy::make_unique<Result<T>>(AnalysisTraits<T>::compute(*this));
+    }
+    return static_cast<Result<T> *>(slot.ptr())->value;
+}
+
+template <typename T>
+T *AnalysisManager::get_cached() const {
+    const auto &slot = m_results[codespy::to_underlying(AnalysisTraits<T>::k_kind)];
+    return slot ? &static_cast<Result<T> *>(slot.ptr())->value : nullptr;
+}
+
+} // namespace codespy::ir
@@ -4,6 +4,7 @@
 #include <codespy/container/Vector.hh>
 #include <codespy/ir/Instruction.hh>
 #include <codespy/ir/Value.hh>
+#include <codespy/support/Span.hh>
 #include <codespy/support/UniquePtr.hh>
 
 namespace codespy::ir {
@@ -46,7 +47,15 @@ public:
     template <HasOpcode Inst, typename... Args>
     Inst *append(Args &&...args);
     void remove(Instruction *inst);
+    // Removes every given instruction, which must all be in this block and have no uses left. They are all unlinked
+    // first and then destroyed together.
+    void remove(Span<Instruction *const> insts);
     void remove_from_parent();
+    // Moves every instruction of from to before the given position. Exception handlers are left in place.
+    void splice(iterator before, BasicBlock *from);
+    // Moves the instructions from at onwards into a new block, which this block then branches to. The new block has no
+    // exception handlers.
+    BasicBlock *split(iterator at);
 
     BasicBlock *successor(unsigned index) const;
     unsigned successor_count() const;
@@ -11,9 +11,15 @@ namespace codespy::ir {
 class PredecessorIterator {
     UserIterator m_it;
 
+    // Only terminators and exception handlers form edges, PHIs also use blocks as incoming values.
+    static bool is_edge(Value *user) {
+        const auto *inst = value_cast<Instruction>(user);
+        return inst != nullptr && (inst->is_terminator() || inst->opcode() == Opcode::ExceptionHandler);
+    }
+
 public:
     explicit PredecessorIterator(UserIterator it) : m_it(it) {
-        if (!it.at_end() && !value_is<Instruction>(*it)) {
+        if (!it.at_end() && !is_edge(*it)) {
             ++*this;
         }
     }
@@ -21,7 +27,7 @@ public:
     PredecessorIterator &operator++() {
         do {
             ++m_it;
-        } while (!m_it.at_end() && !value_is<Instruction>(*m_it));
+        } while (!m_it.at_end() && !is_edge(*m_it));
         return *this;
     }
     PredecessorIterator operator++(int) {
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <codespy/container/HashMap.hh>
+#include <codespy/container/Vector.hh>
+#include <codespy/support/Span.hh>
+
+#include <cstdint>
+
+namespace codespy::ir {
+
+class BasicBlock;
+class Function;
+
+// A read-only copy of the CFG of the reachable blocks of a function. Blocks are given dense ids in reverse postorder,
+// so the entry block is always 0, and edges are stored in compressed sparse row form. Exception handler edges are
+// included, and an edge appears once for every terminator or handler operand forming it. The snapshot must be rebuilt
+// after the CFG changes. Functions without a body have no blocks.
+class CfgSnapshot {
+    Function *m_function;
+    Vector<BasicBlock *> m_blocks;
+    HashMap<BasicBlock *, std::uint32_t> m_ids;
+    // The edges of block i are [offsets[i], offsets[i + 1]).
+    Vector<std::uint32_t> m_succ_offsets;
+    Vector<std::uint32_t> m_succs;
+    Vector<std::uint32_t> m_pred_offsets;
+    Vector<std::uint32_t> m_preds;
+
+public:
+    explicit CfgSnapshot(Function *function);
+
+    bool contains(BasicBlock *block) const { return m_ids.contains(block); }
+    std::uint32_t id(BasicBlock *block) const { return m_ids.at(block); }
+    BasicBlock *block(std::uint32_t id) const { return m_blocks[id]; }
+
+    Span<const std::uint32_t> succs(std::uint32_t id) const {
+        return m_succs.span().subspan(m_succ_offsets[id], m_succ_offsets[id + 1] - m_succ_offsets[id]);
+    }
+    Span<const std::uint32_t> preds(std::uint32_t id) const {
+        return m_preds.span().subspan(m_pred_offsets[id], m_pred_offsets[id + 1] - m_pred_offsets[id]);
+    }
+
+    Function *function() const { return m_function; }
+    // The reachable blocks in reverse postorder.
+    Span<BasicBlock *const> blocks() const { return m_blocks.span(); }
+    std::uint32_t block_count() const { return m_blocks.size(); }
+    std::uint32_t edge_count() const { return m_succs.size(); }
+};
+
+} // namespace codespy::ir
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <codespy/container/Vector.hh>
+#include <codespy/ir/Instruction.hh>
+#include <codespy/support/Span.hh>
+
+#include <cassert>
+#include <cstdint>
+
+namespace codespy::ir {
+
+class Function;
+class Type;
+class Value;
+
+enum class CompactValueKind : std::uint8_t {
+    None,
+    Instruction,
+    Argument,
+    Local,
+    Block,
+    // Constants, functions and fields, i.e. values which don't belong to any one function.
+    Shared,
+};
+
+// An operand of a compact function, packed as a kind in the top bits and an index into the matching table.
+class CompactValue {
+    static constexpr std::uint32_t k_index_bits = 29;
+    std::uint32_t m_bits{0};
+
+public:
+    CompactValue() = default;
+    CompactValue(CompactValueKind kind, std::uint32_t index)
+        : m_bits(static_cast<std::uint32_t>(kind) << k_index_bits | index) {
+        assert(index < (1u << k_index_bits));
+    }
+
+    bool operator==(const CompactValue &) const = default;
+
+    CompactValueKind kind() const { return static_cast<CompactValueKind>(m_bits >> k_index_bits); }
+    std::uint32_t index() const { return m_bits & ((1u << k_index_bits) - 1); }
+};
+
+// An alternative, read-mostly representation of a function body for analysis-heavy batch runs. Instructions are
+// numbered with 32-bit ids, laid out contiguously block by block, and stored as parallel arrays, with every operand in
+// a single pool. Exception handlers are kept separately from the instructions of a block. Uses aren't tracked.
+// Block ids follow the order of the function's block list, so the entry block is always 0, and locals are renumbered
+// densely.
+class CompactFunction {
+    Function *m_function;
+
+    // Per block. The instructions of block i are [inst_offsets[i], inst_offsets[i + 1]), and likewise for handlers.
+    Vector<std::uint32_t> m_inst_offsets;
+    Vector<std::uint32_t> m_handler_offsets;
+    Vector<Type *> m_handler_types;
+    Vector<std::uint32_t> m_handler_targets;
+
+    // Per instruction. The attribute holds whatever else is needed to rebuild the instruction, e.g. the operator of a
+    // binary or compare instruction, see CompactFunction.cc.
+    Vector<Opcode> m_opcodes;
+    Vector<Type *> m_types;
+    Vector<std::uint32_t> m_parents;
+    Vector<std::uint32_t> m_attributes;
+    Vector<std::uint32_t> m_operand_offsets;
+    Vector<CompactValue> m_operands;
+
+    Vector<Type *> m_local_types;
+    Vector<Value *> m_shared_values;
+    // Types referenced by attributes, e.g. the checked type of an instanceof.
+    Vector<Type *> m_attribute_types;
+
+public:
+    explicit CompactFunction(Function *function);
+
+    // Replaces the body of the function this was converted from, which must still have the same arguments, with the
+    // compact one. Any pointers into the old body are invalidated, and locals are recreated with the compact indices.
+    void write_back() const;
+
+    Span<const CompactValue> operands(std::uint32_t inst) const {
+        const auto begin = m_operand_offsets[inst];
+        return m_operands.span().subspan(begin, m_operand_offsets[inst + 1] - begin);
+    }
+    std::uint32_t inst_begin(std::uint32_t block) const { return m_inst_offsets[block]; }
+    std::uint32_t inst_end(std::uint32_t block) const { return m_inst_offsets[block + 1]; }
+    std::uint32_t handler_begin(std::uint32_t block) const { return m_handler_offsets[block]; }
+    std::uint32_t handler_end(std::uint32_t block) const { return m_handler_offsets[block + 1]; }
+
+    Opcode opcode(std::uint32_t inst) const { return m_opcodes[inst]; }
+    Type *type(std::uint32_t inst) const { return m_types[inst]; }
+    std::uint32_t parent(std::uint32_t inst) const { return m_parents[inst]; }
+    std::uint32_t attribute(std::uint32_t inst) const { return m_attributes[inst]; }
+    Type *handler_type(std::uint32_t handler) const { return m_handler_types[handler]; }
+    std::uint32_t handler_target(std::uint32_t handler) const { return m_handler_targets[handler]; }
+    Type *local_type(std::uint32_t local) const { return m_local_types[local]; }
+    Value *shared_value(std::uint32_t index) const { return m_shared_values[index]; }
+
+    Function *function() const { return m_function; }
+    std::uint32_t block_count() const { return m_inst_offsets.size() - 1; }
+    std::uint32_t inst_count() const { return m_opcodes.size(); }
+    std::uint32_t local_count() const { return m_local_types.size(); }
+};
+
+} // namespace codespy::ir
@@ -1,15 +1,60 @@
 #pragma once
 
+#include <codespy/container/Array.hh>
+#include <codespy/container/HashMap.hh>
 #include <codespy/container/Vector.hh>
 #include <codespy/ir/Constant.hh>
 #include <codespy/ir/Type.hh>
+#include <codespy/support/Hash.hh>
+#include <codespy/support/HashedString.hh>
 #include <codespy/support/UniquePtr.hh>
 
-#include <unordered_map>
+#include <cstdint>
+#include <mutex>
+#include <shared_mutex>
 
 namespace codespy::ir {
 
+// Owns and interns all types and constants. Interning is thread safe, so a single context can be shared by frontends
+// lifting on multiple threads. Interned pointers stay valid for the lifetime of the context.
 class Context {
+    // A hash map split into independently locked shards. Looking up a key that is already interned, by far the common
+    // case, only takes a shared lock, and inserts only contend with other threads whose keys land in the same shard.
+    template <typename K, typename V, typename Hash = codespy::Hash<K>>
+    class InternTable {
+        static constexpr std::size_t k_shard_bits = 4;
+
+        struct alignas(64) Shard {
+            std::shared_mutex mutex;
+            HashMap<K, UniquePtr<V>, Hash> map;
+        };
+        Array<Shard, 1u << k_shard_bits> m_shards;
+
+    public:
+        // Returns the value interned for key, calling create to make it if there isn't one yet.
+        template <typename F>
+        V *intern(const K &key, F create) {
+            // Take the shard from the top bits of a Fibonacci hash, since pointer and integer hashes are often the
+            // identity and so have little entropy in their low bits.
+            const auto hash = static_cast<std::uint64_t>(Hash{}(key)) * 0x9e3779b97f4a7c15u;
+            auto &shard = m_shards[hash >> (64 - k_shard_bits)];
+            {
+                std::shared_lock lock(shard.mutex);
+                if (auto it = shard.map.find(key); it != shard.map.end()) {
+                    return it->second.ptr();
+                }
+            }
+            // Another thread may have inserted the key in between the two locks, in which case the slot is already
+            // filled.
+            std::unique_lock lock(shard.mutex);
+            auto &slot = shard.map[key];
+            if (!slot) {
+                slot = create();
+            }
+            return slot.ptr();
+        }
+    };
+
     struct ConstantIntKey {
         std::int64_t value;
         std::uint16_t bit_width;
@@ -35,18 +80,18 @@ class Context {
     };
 
     struct ConstantIntKeyHash {
+        using is_avalanching = void;
         std::size_t operator()(const ConstantIntKey &key) const {
-            // TODO: Actual int hash.
-            return codespy::hash_combine(key.value, key.bit_width);
+            return codespy::hash_combine(codespy::hash_int(static_cast<std::uint64_t>(key.value)), key.bit_width);
         }
     };
 
     struct FunctionTypeKeyHash {
+        using is_avalanching = void;
         std::size_t operator()(const FunctionTypeKey &key) const {
-            // TODO: Actual pointer hash.
-            auto hash = std::hash<Type *>{}(key.return_type);
+            auto hash = codespy::Hash<Type *>{}(key.return_type);
             for (auto *type : key.parameter_types) {
-                hash = codespy::hash_combine(hash, std::hash<Type *>{}(type));
+                hash = codespy::hash_combine(hash, reinterpret_cast<std::uintptr_t>(type));
             }
             return hash;
         }
@@ -58,17 +103,17 @@ private:
     Type m_float_type{TypeKind::Float};
     Type m_double_type{TypeKind::Double};
     Type m_void_type{TypeKind::Void};
-    std::unordered_map<Type *, UniquePtr<ArrayType>> m_array_types;
-    std::unordered_map<std::uint16_t, UniquePtr<IntType>> m_int_types;
-    std::unordered_map<String, UniquePtr<ReferenceType>> m_reference_types;
-    std::unordered_map<FunctionTypeKey, UniquePtr<FunctionType>, FunctionTypeKeyHash> m_function_types;
+    InternTable<Type *, ArrayType> m_array_types;
+    InternTable<std::uint16_t, IntType> m_int_types;
+    InternTable<HashedString, ReferenceType> m_reference_types;
+    InternTable<FunctionTypeKey, FunctionType, FunctionTypeKeyHash> m_function_types;
 
     Value m_constant_null;
-    std::unordered_map<double, UniquePtr<ConstantDouble>> m_double_constants;
-    std::unordered_map<float, UniquePtr<ConstantFloat>> m_float_constants;
-    std::unordered_map<ConstantIntKey, UniquePtr<ConstantInt>, ConstantIntKeyHash> m_int_constants;
-    std::unordered_map<String, UniquePtr<ConstantString>> m_string_constants;
-    std::unordered_map<Type *, UniquePtr<PoisonValue>> m_poison_values;
+    InternTable<double, ConstantDouble> m_double_constants;
+    InternTable<float, ConstantFloat> m_float_constants;
+    InternTable<ConstantIntKey, ConstantInt, ConstantIntKeyHash> m_int_constants;
+    InternTable<HashedString, ConstantString> m_string_constants;
+    InternTable<Type *, PoisonValue> m_poison_values;
 
 public:
     Context();
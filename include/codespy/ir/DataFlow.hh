@@ -0,0 +1,56 @@
+#pragma once
+
+#include <codespy/container/BitMatrix.hh>
+
+#include <cstdint>
+
+namespace codespy::ir {
+
+class CfgSnapshot;
+
+enum class DataFlowDirection {
+    Forward,
+    Backward,
+};
+
+enum class DataFlowMeet {
+    // May analyses, e.g. liveness. Sets start empty.
+    Union,
+    // Must analyses, e.g. available expressions. Sets start full.
+    Intersection,
+};
+
+// Iterative bit vector dataflow over a CFG snapshot, with one row per block id and one column per fact. Each block's
+// transfer function is gen | (x - kill), where x is the meet of the neighbouring blocks in the direction of the
+// analysis. The boundary set additionally flows into the entry block for forward problems, and into blocks with no
+// successors for backward ones.
+// Blocks are visited in order of a priority worklist, reverse postorder for forward problems and postorder for backward
+// ones, so that most problems converge in very few passes. Nothing is allocated once the solver has been constructed.
+class BitDataFlow {
+    const CfgSnapshot &m_cfg;
+    const DataFlowDirection m_direction;
+    const DataFlowMeet m_meet;
+    BitMatrix m_gen;
+    BitMatrix m_kill;
+    BitMatrix m_boundary;
+    BitMatrix m_entry_sets;
+    BitMatrix m_exit_sets;
+    BitMatrix m_pending;
+
+public:
+    BitDataFlow(const CfgSnapshot &cfg, std::uint32_t fact_count, DataFlowDirection direction, DataFlowMeet meet);
+
+    void solve();
+
+    // Set up the problem with these before calling solve.
+    BitMatrix &gen() { return m_gen; }
+    BitMatrix &kill() { return m_kill; }
+    void set_boundary(std::uint32_t fact) { m_boundary.set(0, fact); }
+
+    // The facts holding at the start and end of each block.
+    const BitMatrix &entry_sets() const { return m_entry_sets; }
+    const BitMatrix &exit_sets() const { return m_exit_sets; }
+    const CfgSnapshot &cfg() const { return m_cfg; }
+};
+
+} // namespace codespy::ir
@@ -1,32 +1,112 @@
 #pragma once
 
-#include <codespy/support/IteratorRange.hh>
+#include <codespy/container/BitVector.hh>
+#include <codespy/container/HashMap.hh>
+#include <codespy/container/Vector.hh>
+#include <codespy/support/Span.hh>
 
-#include <unordered_map>
-#include <unordered_set>
+#include <cstdint>
 
 namespace codespy::ir {
 
 class BasicBlock;
+class CfgSnapshot;
 class Function;
 class Instruction;
 
+enum class DominanceAlgorithm {
+    // Pick based on the number of blocks in the function.
+    Auto,
+    // Iterative Cooper-Harvey-Kennedy, fast for small CFGs.
+    Iterative,
+    // Near-linear Semi-NCA, scales better to very large CFGs.
+    SemiNca,
+};
+
+enum class CfgUpdateKind {
+    Insert,
+    Delete,
+};
+
+// A change in the existence of the edge from -> to. An insertion should only be reported if no such edge existed
+// before, and a deletion only if no such edge remains afterwards.
+struct CfgUpdate {
+    CfgUpdateKind kind;
+    BasicBlock *from;
+    BasicBlock *to;
+};
+
 class DominanceInfo {
-    std::unordered_map<BasicBlock *, BasicBlock *> m_idoms;
-    std::unordered_map<BasicBlock *, std::unordered_set<BasicBlock *>> m_frontiers;
+    friend class DominanceUpdater;
+    friend DominanceInfo compute_dominance(const CfgSnapshot &cfg, DominanceAlgorithm algorithm);
+
+    struct Node {
+        BasicBlock *idom;
+        unsigned level;
+        // Dense index for use in bitsets, stable for as long as the block stays reachable.
+        unsigned index;
+        Vector<BasicBlock *> children;
+    };
+
+    Function *m_function;
+    HashMap<BasicBlock *, Node> m_nodes;
+    unsigned m_index_count{0};
+
+    void set_idom(BasicBlock *block, BasicBlock *idom);
 
 public:
-    DominanceInfo(std::unordered_map<BasicBlock *, BasicBlock *> &&idoms,
-                  std::unordered_map<BasicBlock *, std::unordered_set<BasicBlock *>> &&frontiers)
-        : m_idoms(std::move(idoms)), m_frontiers(std::move(frontiers)) {}
+    explicit DominanceInfo(Function *function) : m_function(function) {}
+
+    // Update the tree after the CFG has been mutated. The updates must be given in the order in which the changes were
+    // made, and any block referenced must stay alive until this returns.
+    void apply_updates(Span<const CfgUpdate> updates);
+    void insert_edge(BasicBlock *from, BasicBlock *to);
+    void delete_edge(BasicBlock *from, BasicBlock *to);
+
+    // Forget a block that is about to be removed from the function. Any edge deletions that made it unreachable must
+    // have already been applied.
+    void remove_block(BasicBlock *block);
+    // Forget a block that has been merged into its single predecessor. Its children in the tree are moved up.
+    void merge_block(BasicBlock *block);
 
     bool dominates(BasicBlock *dominator, BasicBlock *block) const;
     bool strictly_dominates(BasicBlock *dominator, BasicBlock *block) const;
     bool dominates(Instruction *def, Instruction *user) const;
-    IteratorRange<std::unordered_set<BasicBlock *>::const_iterator> frontiers(BasicBlock *block) const;
-    const std::unordered_map<BasicBlock *, BasicBlock *> &idoms() const { return m_idoms; }
+    bool is_reachable(BasicBlock *block) const { return m_nodes.contains(block); }
+    BasicBlock *idom(BasicBlock *block) const;
+    BasicBlock *nearest_common_dominator(BasicBlock *lhs, BasicBlock *rhs) const;
+    // Computes the iterated dominance frontier of the given set of blocks, i.e. the blocks which need a PHI for a
+    // variable defined in def_blocks. Prefer IteratedFrontier when computing more than one.
+    Vector<BasicBlock *> iterated_frontier(Span<BasicBlock *const> def_blocks) const;
+    const Vector<BasicBlock *> &children(BasicBlock *block) const { return m_nodes.at(block).children; }
+    Function *function() const { return m_function; }
+};
+
+// Computes iterated dominance frontiers over a CFG snapshot, with blocks given by snapshot id. The dominator tree is
+// flattened on construction so that computing the frontiers of many sets of blocks, e.g. one per promoted local, only
+// walks arrays. The dominance info must be up to date with the snapshot.
+class IteratedFrontier {
+    const CfgSnapshot &m_cfg;
+    Vector<std::uint32_t> m_levels;
+    // The dominator tree children of block i are [offsets[i], offsets[i + 1]).
+    Vector<std::uint32_t> m_child_offsets;
+    Vector<std::uint32_t> m_children;
+    BitVector m_is_def;
+    BitVector m_visited_queue;
+    BitVector m_visited_worklist;
+    Vector<std::uint32_t> m_worklist;
+
+    Span<const std::uint32_t> children(std::uint32_t id) const {
+        return m_children.span().subspan(m_child_offsets[id], m_child_offsets[id + 1] - m_child_offsets[id]);
+    }
+
+public:
+    IteratedFrontier(const CfgSnapshot &cfg, const DominanceInfo &dom_info);
+
+    Vector<std::uint32_t> compute(Span<const std::uint32_t> def_blocks);
 };
 
-DominanceInfo compute_dominance(Function *function);
+DominanceInfo compute_dominance(Function *function, DominanceAlgorithm algorithm = DominanceAlgorithm::Auto);
+DominanceInfo compute_dominance(const CfgSnapshot &cfg, DominanceAlgorithm algorithm = DominanceAlgorithm::Auto);
 
 } // namespace codespy::ir
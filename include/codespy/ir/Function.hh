@@ -38,6 +38,7 @@ class Function : public Value, public ListNode {
     List<Argument> m_arguments;
     List<Local> m_locals;
     List<BasicBlock> m_blocks;
+    unsigned m_local_count{0};
 
 public:
     static constexpr auto k_kind = ValueKind::Function;
@@ -49,6 +50,8 @@ public:
     Argument *argument(std::size_t index);
     void remove_block(BasicBlock *block);
     void remove_local(Local *local);
+    // Removes every local, none of which may have uses, and starts numbering new locals from 0 again.
+    void remove_locals();
     void set_name_prefix(String name_prefix);
 
     BasicBlock *entry_block() const;
@@ -60,6 +63,8 @@ public:
     const List<Argument> &arguments() const { return m_arguments; }
     const List<BasicBlock> &blocks() const { return m_blocks; }
     const List<Local> &locals() const { return m_locals; }
+    // An upper bound on local indices, which are only reused after remove_locals.
+    unsigned local_count() const { return m_local_count; }
 };
 
 } // namespace codespy::ir
@@ -2,27 +2,50 @@
 
 #include <codespy/container/ListNode.hh>
 #include <codespy/ir/Value.hh>
+#include <codespy/support/IteratorRange.hh>
 
 #include <cstdint>
 
 namespace codespy::ir {
 
 class BasicBlock;
+class Instruction;
 class Visitor;
 
+// Iterates over a run of an instruction's operands by index, without copying them out.
+class OperandIterator {
+    const Instruction *m_inst;
+    unsigned m_index;
+
+public:
+    OperandIterator(const Instruction *inst, unsigned index) : m_inst(inst), m_index(index) {}
+
+    OperandIterator &operator++() {
+        m_index++;
+        return *this;
+    }
+    bool operator==(const OperandIterator &) const = default;
+    Value *operator*() const;
+};
+
 enum class Opcode : std::uint8_t {
 #define INST(opcode, Class) opcode,
 #include <codespy/ir/Instructions.in>
 };
 
 class Instruction : public Value, public ListNode {
+    friend class BasicBlock;
+    friend class CompactFunction;
+
+private:
     const Opcode m_opcode;
-    BasicBlock *const m_parent;
+    const unsigned m_operand_count;
+    BasicBlock *m_parent;
     Use *m_operands;
 
 protected:
     Instruction(Opcode opcode, BasicBlock *parent, Type *type, unsigned operand_count)
-        : Value(k_kind, type), m_opcode(opcode), m_parent(parent),
+        : Value(k_kind, type), m_opcode(opcode), m_operand_count(operand_count), m_parent(parent),
           m_operands(operand_count != 0 ? new Use[operand_count] : nullptr) {
         for (unsigned i = 0; i < operand_count; i++) {
             m_operands[i].set_owner(this);
@@ -30,7 +53,6 @@ protected:
     }
     ~Instruction();
 
-    Value *operand(unsigned index) const;
     void set_operand(unsigned index, Value *value);
 
 public:
@@ -43,16 +65,28 @@ public:
     Instruction &operator=(Instruction &&) = delete;
 
     void accept(Visitor &visitor);
+    // Unlinks every operand from the use list of its value, leaving it null. Only useful right before removal.
+    void drop_operands();
     void remove_from_parent();
     BasicBlock *successor(unsigned index) const;
     unsigned successor_count() const;
 
+    // Raw operand access, mostly useful for generic passes. Note that operands may be null, e.g. unset PHI incoming.
+    Value *operand(unsigned index) const;
+    unsigned operand_count() const { return m_operand_count; }
+
     bool is_terminator() const;
+    // Whether the instruction can raise an exception, i.e. whether it needs to be covered by its block's handlers.
+    bool may_throw() const;
     Opcode opcode() const { return m_opcode; }
     BasicBlock *parent() const { return m_parent; }
     bool has_operands() const { return m_operands != nullptr; }
 };
 
+inline Value *OperandIterator::operator*() const {
+    return m_inst->operand(m_index);
+}
+
 template <typename T>
 concept HasOpcode = requires(T) { static_cast<Opcode>(T::k_opcode); };
 
@@ -75,7 +75,11 @@ public:
     void set_is_invoke_special(bool is_invoke_special) { m_is_invoke_special = is_invoke_special; }
 
     Function *callee() const;
-    Vector<Value *> arguments() const;
+    Value *argument(unsigned index) const { return operand(index + 1); }
+    unsigned argument_count() const { return operand_count() - 1; }
+    auto arguments() const {
+        return codespy::make_range(OperandIterator(this, 1), OperandIterator(this, operand_count()));
+    }
     bool is_invoke_special() const { return m_is_invoke_special; }
 };
 
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <codespy/ir/DataFlow.hh>
+
+#include <cstdint>
+
+namespace codespy::ir {
+
+class CfgSnapshot;
+class Local;
+
+// Liveness of locals at block boundaries for a function in memory form, i.e. before locals are promoted. Facts are
+// indexed by Local::index().
+class LocalLiveness {
+    BitDataFlow m_data_flow;
+
+public:
+    explicit LocalLiveness(const CfgSnapshot &cfg);
+
+    bool is_live_in(std::uint32_t block, const Local *local) const;
+    bool is_live_out(std::uint32_t block, const Local *local) const;
+
+    // Rows are block ids, columns local indices.
+    const BitMatrix &live_in() const { return m_data_flow.entry_sets(); }
+    const BitMatrix &live_out() const { return m_data_flow.exit_sets(); }
+};
+
+} // namespace codespy::ir
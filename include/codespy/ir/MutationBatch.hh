@@ -0,0 +1,39 @@
+#pragma once
+
+#include <codespy/container/HashMap.hh>
+#include <codespy/container/Vector.hh>
+
+#include <utility>
+
+namespace codespy::ir {
+
+class Instruction;
+class Value;
+
+// Queues replacements and instruction removals so that they can all be applied in one go. Nothing in the IR changes
+// until apply() is called, so blocks can be iterated over normally while queueing, but any value read back out of the
+// IR in the meantime may need to be looked through resolve().
+class MutationBatch {
+    // Replacements in the order they were queued, with an index for resolve().
+    Vector<std::pair<Value *, Value *>> m_replacements;
+    HashMap<Value *, Value *> m_replacement_map;
+    Vector<Instruction *> m_removals;
+
+public:
+    // Queues replacing every use of from with to. A value can only be replaced once.
+    void replace_all_uses_with(Value *from, Value *to);
+    // Queues removing the instruction from its block. Any remaining uses of it must be replaced too.
+    void remove(Instruction *inst);
+    void replace_and_remove(Instruction *inst, Value *value);
+
+    // Returns the value which will end up in place of the given one.
+    Value *resolve(Value *value) const;
+
+    // Applies the replacements, then drops the operands of the removed instructions before deleting them, so that
+    // removed instructions referring to each other don't need to be ordered. Removals are grouped by block, and each
+    // block unlinks all of its removed instructions before any of them are destroyed.
+    void apply();
+    bool empty() const { return m_replacements.empty() && m_removals.empty(); }
+};
+
+} // namespace codespy::ir
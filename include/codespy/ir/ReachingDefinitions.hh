@@ -0,0 +1,29 @@
+#pragma once
+
+#include <codespy/container/Vector.hh>
+#include <codespy/ir/DataFlow.hh>
+#include <codespy/support/Span.hh>
+
+#include <cstdint>
+
+namespace codespy::ir {
+
+class CfgSnapshot;
+class StoreInst;
+
+// The stores to locals which may reach each block boundary, for a function in memory form. Facts are indices into
+// stores(), which holds every store to a local in a reachable block.
+class ReachingDefinitions {
+    Vector<StoreInst *> m_stores;
+    BitDataFlow m_data_flow;
+
+public:
+    explicit ReachingDefinitions(const CfgSnapshot &cfg);
+
+    Span<StoreInst *const> stores() const { return m_stores.span(); }
+    // Rows are block ids, columns store indices.
+    const BitMatrix &reaching_in() const { return m_data_flow.entry_sets(); }
+    const BitMatrix &reaching_out() const { return m_data_flow.exit_sets(); }
+};
+
+} // namespace codespy::ir
@@ -13,6 +13,9 @@ class Type;
 class Value;
 
 class Use {
+    friend class Value;
+
+private:
     // TODO: This should be const.
     Value *m_owner{nullptr};
     Use **m_prev{nullptr};
@@ -24,7 +27,7 @@ public:
     Use(const Use &) = delete;
     Use(Use &&) = delete;
     ~Use() {
-        if (m_value != nullptr) {
+        if (is_linked()) {
             remove_from_list();
         }
     }
@@ -37,6 +40,9 @@ public:
     void set(Value *value);
     void set_owner(Value *owner) { m_owner = owner; }
 
+    // Whether the use is in its value's use list, which is never the case for untracked values.
+    bool is_linked() const { return m_prev != nullptr; }
+
     Use *next() const { return m_next; }
     Value *owner() const { return m_owner; }
     Value *value() const { return m_value; }
@@ -105,6 +111,10 @@ public:
     void destroy();
     void replace_all_uses_with(Value *value);
 
+    // Constants and other values shared between every function don't keep a use list, so that setting an operand to
+    // one never has to write to memory outside of the function being changed. Their users() are always empty.
+    bool tracks_uses() const;
+
     auto user_begin() const { return UserIterator(m_use_list); }
     auto user_end() const { return UserIterator(nullptr); } // NOLINT
     auto users() const { return codespy::make_range(user_begin(), user_end()); }
@@ -114,6 +124,22 @@ public:
     ValueKind kind() const { return m_kind; }
 };
 
+inline bool Value::tracks_uses() const {
+    switch (m_kind) {
+    case ValueKind::ConstantDouble:
+    case ValueKind::ConstantFloat:
+    case ValueKind::ConstantInt:
+    case ValueKind::ConstantNull:
+    case ValueKind::ConstantString:
+    case ValueKind::Function:
+    case ValueKind::JavaField:
+    case ValueKind::Poison:
+        return false;
+    default:
+        return true;
+    }
+}
+
 template <typename T>
 concept HasValueKind = requires(T) { static_cast<ValueKind>(T::k_kind); };
 
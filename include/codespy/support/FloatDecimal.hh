@@ -0,0 +1,18 @@
+#pragma once
+
+#include <cstdint>
+
+namespace codespy {
+
+// A positive floating point value as significand * 10^exponent, where the significand has as few digits as possible
+// while still converting back to the same value. Among the candidates of that length, the closest one is used.
+struct FloatDecimal {
+    std::uint64_t significand;
+    std::int32_t exponent;
+};
+
+// The value must be finite and non-zero, and its sign is ignored.
+FloatDecimal to_shortest_decimal(double value);
+FloatDecimal to_shortest_decimal(float value);
+
+} // namespace codespy
@@ -1,13 +1,17 @@
 #pragma once
 
+#include <codespy/support/FormatString.hh>
 #include <codespy/support/String.hh>
 #include <codespy/support/StringBuilder.hh>
 #include <codespy/support/StringView.hh>
 
+#include <type_traits>
+#include <utility>
+
 namespace codespy {
 
 template <typename... Args>
-String format(StringView fmt, Args &&...args) {
+String format(FormatString<std::remove_cvref_t<Args>...> fmt, Args &&...args) {
     StringBuilder builder;
     builder.append(fmt, std::forward<Args>(args)...);
     return builder.build();
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <codespy/container/Array.hh>
+#include <codespy/support/StringView.hh>
+
+#include <cstddef>
+
+namespace codespy {
+
+// Not constexpr, so that reaching it while parsing a format string fails compilation, with the name as the message.
+void invalid_format_string();
+
+// A format string literal, split into literal chunks and placeholders at compile time. Each placeholder is written as
+// {} or {opts}, with up to three option characters, see StringBuilder.cc. There must be exactly one placeholder per
+// argument.
+template <typename... Args>
+class FormatString {
+public:
+    struct Segment {
+        // The literal text before the placeholder.
+        StringView literal;
+        // The null-terminated placeholder options.
+        Array<char, 4> opts{};
+    };
+
+private:
+    // One per argument, plus the trailing literal text, which has no placeholder.
+    Array<Segment, sizeof...(Args) + 1> m_segments{};
+
+public:
+    template <std::size_t N>
+    consteval FormatString(const char (&fmt)[N]);
+
+    constexpr const Segment &segment(std::size_t index) const { return m_segments[index]; }
+    constexpr StringView trailing() const { return m_segments.last().literal; }
+};
+
+template <typename... Args>
+template <std::size_t N>
+consteval FormatString<Args...>::FormatString(const char (&fmt)[N]) {
+    // N includes the null terminator.
+    std::size_t index = 0;
+    for (auto &segment : m_segments) {
+        const std::size_t begin = index;
+        while (index < N - 1 && fmt[index] != '{') {
+            index++;
+        }
+        segment.literal = StringView(fmt + begin, index - begin);
+        if (&segment == &m_segments.last()) {
+            if (index != N - 1) {
+                // More placeholders than arguments.
+                invalid_format_string();
+            }
+            break;
+        }
+        if (index == N - 1) {
+            // Fewer placeholders than arguments.
+            invalid_format_string();
+        }
+        index++;
+        for (std::size_t i = 0; index < N - 1 && fmt[index] != '}'; i++) {
+            if (i == segment.opts.size() - 1) {
+                // Too many options.
+                invalid_format_string();
+            }
+            segment.opts[i] = fmt[index++];
+        }
+        if (index == N - 1) {
+            // Unterminated placeholder.
+            invalid_format_string();
+        }
+        index++;
+    }
+}
+
+} // namespace codespy
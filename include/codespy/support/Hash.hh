@@ -0,0 +1,81 @@
+#pragma once
+
+#include <codespy/support/StringView.hh>
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <type_traits>
+#include <utility>
+
+namespace codespy {
+
+// Multiplies to 128 bits and folds the halves back together, so that every input bit affects every output bit.
+inline std::uint64_t hash_mix(std::uint64_t lhs, std::uint64_t rhs) {
+#ifdef __SIZEOF_INT128__
+    const auto product = static_cast<unsigned __int128>(lhs) * rhs;
+    return static_cast<std::uint64_t>(product) ^ static_cast<std::uint64_t>(product >> 64u);
+#else
+    const auto lhs_lo = lhs & 0xffffffffu;
+    const auto lhs_hi = lhs >> 32u;
+    const auto rhs_lo = rhs & 0xffffffffu;
+    const auto rhs_hi = rhs >> 32u;
+    const auto lo_lo = lhs_lo * rhs_lo;
+    const auto hi_lo = lhs_hi * rhs_lo;
+    const auto lo_hi = lhs_lo * rhs_hi;
+    const auto hi_hi = lhs_hi * rhs_hi;
+    const auto cross = (lo_lo >> 32u) + (hi_lo & 0xffffffffu) + lo_hi;
+    const auto hi = hi_hi + (hi_lo >> 32u) + (cross >> 32u);
+    const auto lo = (cross << 32u) | (lo_lo & 0xffffffffu);
+    return lo ^ hi;
+#endif
+}
+
+inline std::size_t hash_int(std::uint64_t value) {
+    return hash_mix(value ^ 0x2d358dccaa6c78a5u, 0x8bb84b93962eacc9u);
+}
+
+inline std::size_t hash_combine(std::size_t lhs, std::size_t rhs) {
+    return hash_mix(lhs ^ 0x4b33a62ed433d4a3u, rhs ^ 0x4d5a2da51de1aa47u);
+}
+
+// A wyhash style hash of arbitrary bytes.
+std::size_t hash_bytes(const void *data, std::size_t length);
+
+inline std::size_t hash_string(StringView string) {
+    return hash_bytes(string.data(), string.length());
+}
+
+// The hash used by HashMap and HashSet by default. Specialisations which fully mix their output define is_avalanching,
+// so that the tables can skip mixing it again. Anything else falls back to std::hash.
+template <typename T>
+struct Hash : std::hash<T> {};
+
+template <typename T>
+    requires(std::is_integral_v<T> || std::is_enum_v<T> || std::is_pointer_v<T>)
+struct Hash<T> {
+    using is_avalanching = void;
+    std::size_t operator()(T value) const {
+        if constexpr (std::is_pointer_v<T>) {
+            return hash_int(reinterpret_cast<std::uintptr_t>(value));
+        } else {
+            return hash_int(static_cast<std::uint64_t>(value));
+        }
+    }
+};
+
+template <>
+struct Hash<StringView> {
+    using is_avalanching = void;
+    std::size_t operator()(StringView string) const { return hash_string(string); }
+};
+
+template <typename T, typename U>
+struct Hash<std::pair<T, U>> {
+    using is_avalanching = void;
+    std::size_t operator()(const std::pair<T, U> &pair) const {
+        return hash_combine(Hash<T>{}(pair.first), Hash<U>{}(pair.second));
+    }
+};
+
+} // namespace codespy
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <codespy/support/Hash.hh>
+#include <codespy/support/String.hh>
+#include <codespy/support/StringView.hh>
+
+#include <cstddef>
+#include <utility>
+
+namespace codespy {
+
+// A string that carries its own hash, for keys which are hashed over and over again, e.g. when interning or when a
+// table is rehashed. Comparisons check the hash before the contents.
+class HashedString {
+    String m_string;
+    std::size_t m_hash;
+
+public:
+    explicit HashedString(String string) : m_string(std::move(string)), m_hash(hash_string(m_string)) {}
+    HashedString(const HashedString &) = default;
+    HashedString(HashedString &&) = default;
+    ~HashedString() = default;
+
+    HashedString &operator=(const HashedString &) = delete;
+    HashedString &operator=(HashedString &&) = default;
+
+    bool operator==(const HashedString &other) const {
+        return m_hash == other.m_hash && m_string == other.m_string;
+    }
+
+    operator StringView() const { return m_string.view(); }
+    const String &string() const { return m_string; }
+    StringView view() const { return m_string.view(); }
+    std::size_t hash() const { return m_hash; }
+};
+
+template <>
+struct Hash<HashedString> {
+    using is_avalanching = void;
+    std::size_t operator()(const HashedString &string) const { return string.hash(); }
+};
+
+} // namespace codespy
@@ -1,8 +1,10 @@
 #pragma once
 
 #include <codespy/support/Format.hh>
+#include <codespy/support/FormatString.hh>
 #include <codespy/support/StringView.hh>
 
+#include <type_traits>
 #include <utility>
 
 namespace codespy {
@@ -11,12 +13,12 @@ void print(StringView);
 void println(StringView);
 
 template <typename... Args>
-void print(StringView fmt, Args &&...args) {
+void print(FormatString<std::remove_cvref_t<Args>...> fmt, Args &&...args) {
     print(codespy::format(fmt, std::forward<Args>(args)...));
 }
 
 template <typename... Args>
-void println(StringView fmt, Args &&...args) {
+void println(FormatString<std::remove_cvref_t<Args>...> fmt, Args &&...args) {
     println(codespy::format(fmt, std::forward<Args>(args)...));
 }
 
@@ -33,7 +33,7 @@ public:
     // Allow implicit conversion from `Span<T>` to `Span<void>`.
     constexpr operator Span<void>() const requires(!std::is_const_v<T>) { return {data(), size_bytes()}; }
     constexpr operator Span<const void>() const requires(!is_void) { return {data(), size_bytes()}; }
-    constexpr operator Span<const T>() const { return {data(), size_bytes()}; }
+    constexpr operator Span<const T>() const { return {data(), size()}; }
 
     constexpr T *begin() const { return m_data; }
     constexpr T *end() const { return m_data + m_size; }
@@ -1,53 +1,87 @@
 #pragma once
 
+#include <codespy/support/Hash.hh>
 #include <codespy/support/Span.hh>
 #include <codespy/support/StringView.hh>
 #include <codespy/support/Utility.hh>
 
 #include <cstddef>
+#include <cstdint>
 #include <functional>
-#include <string_view>
 #include <utility>
 
 namespace codespy {
 
+// An owned, null terminated string. Strings of up to k_inline_capacity characters, which covers most identifiers and
+// descriptors in class files, are stored inline without allocating, in the space the heap pointer and length would
+// otherwise take.
 class String {
-    char *m_data{nullptr};
-    std::size_t m_length{0};
+    static constexpr std::size_t k_inline_capacity = 22;
+    static constexpr std::uint8_t k_heap_tag = 0xff;
+
+    // Both layouts start with the tag, so it can be read through either. Inline strings keep their length in it.
+    struct InlineStorage {
+        std::uint8_t tag;
+        char chars[k_inline_capacity + 1];
+    };
+    struct HeapStorage {
+        std::uint8_t tag;
+        char *data;
+        std::size_t length;
+    };
+    union Storage {
+        InlineStorage small;
+        HeapStorage heap;
+    };
+    Storage m_storage{};
+
+    bool is_inline() const { return m_storage.small.tag != k_heap_tag; }
+    char *raw_data() const { return is_inline() ? const_cast<char *>(m_storage.small.chars) : m_storage.heap.data; }
+    void move_from(String &other);
 
 public:
     static String copy_raw(const char *data, std::size_t length);
+    // Takes ownership of a heap allocated, null terminated buffer.
     static String move_raw(char *data, std::size_t length);
 
     constexpr String() = default;
     explicit String(std::size_t length);
     String(const char *c_string) : String(copy_raw(c_string, __builtin_strlen(c_string))) {}
     String(StringView view) : String(copy_raw(view.data(), view.length())) {}
-    String(const String &other) : String(copy_raw(other.m_data, other.m_length)) {}
-    String(String &&other)
-        : m_data(std::exchange(other.m_data, nullptr)), m_length(std::exchange(other.m_length, 0u)) {}
+    String(const String &other) : String(copy_raw(other.data(), other.length())) {}
+    String(String &&other) { move_from(other); }
     ~String();
 
     String &operator=(const String &) = delete;
     String &operator=(String &&);
 
-    char *begin() const { return m_data; }
-    char *end() const { return m_data + m_length; }
+    char *begin() const { return raw_data(); }
+    char *end() const { return raw_data() + length(); }
 
-    char *data() { return m_data; }
-    const char *data() const { return m_data; }
+    char *data() { return raw_data(); }
+    const char *data() const { return raw_data(); }
 
     bool ends_with(StringView end);
 
     operator StringView() const { return view(); }
-    StringView view() const { return {m_data, m_length}; }
+    StringView view() const { return {raw_data(), length()}; }
 
-    char *disown() { return std::exchange(m_data, nullptr); }
+    // Releases the buffer, which the caller must free with delete[], and leaves the string empty. Inline strings are
+    // copied to the heap first.
+    char *disown();
 
     bool operator==(const String &other) const;
     bool operator==(StringView other) const;
-    bool empty() const { return m_length == 0; }
-    std::size_t length() const { return m_length; }
+    bool empty() const { return length() == 0; }
+    std::size_t length() const { return is_inline() ? m_storage.small.tag : m_storage.heap.length; }
+};
+
+static_assert(sizeof(String) == 24);
+
+template <>
+struct Hash<String> {
+    using is_avalanching = void;
+    std::size_t operator()(const String &string) const { return hash_string(string); }
 };
 
 } // namespace codespy
@@ -56,9 +90,7 @@ namespace std {
 
 template <>
 struct hash<codespy::String> {
-    std::size_t operator()(const codespy::String &string) const {
-        return hash<std::string_view>{}(std::string_view{string.data(), string.length()});
-    }
+    std::size_t operator()(const codespy::String &string) const { return codespy::hash_string(string); }
 };
 
 } // namespace std
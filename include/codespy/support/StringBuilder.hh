@@ -2,6 +2,7 @@
 
 #include <codespy/container/Array.hh>
 #include <codespy/container/Vector.hh>
+#include <codespy/support/FormatString.hh>
 #include <codespy/support/Span.hh>
 #include <codespy/support/String.hh>
 #include <codespy/support/StringView.hh>
@@ -9,13 +10,16 @@
 #include <concepts>
 #include <cstddef>
 #include <cstdint>
+#include <type_traits>
 
 namespace codespy {
 
 class StringBuilder {
     LargeVector<char> m_buffer;
 
+    char *grow(std::size_t by);
     void append_single(double, const char *);
+    void append_single(float, const char *);
     void append_single(std::int64_t, const char *);
     void append_single(std::uint64_t, const char *);
     void append_single(StringView, const char *);
@@ -30,12 +34,10 @@ class StringBuilder {
         append_single(static_cast<std::uint64_t>(arg), opts);
     }
 
-    template <typename T>
-    void append_part(StringView fmt, std::size_t &index, const T &arg);
-
 public:
     template <typename... Args>
-    void append(StringView fmt, const Args &...args);
+    void append(FormatString<std::remove_cvref_t<Args>...> fmt, const Args &...args);
+    void append(StringView string);
     void append(char ch);
     void truncate(std::size_t by);
 
@@ -46,30 +48,16 @@ public:
     size_t length() const { return m_buffer.size(); }
 };
 
-template <typename T>
-void StringBuilder::append_part(StringView fmt, size_t &index, const T &arg) {
-    while (index < fmt.length() && fmt[index] != '{') {
-        m_buffer.push(fmt[index++]);
-    }
-
-    if (index >= fmt.length() || fmt[index++] != '{') {
-        return;
-    }
-
-    Array<char, 4> opts{};
-    for (uint32_t i = 0; i < opts.size() && fmt[index] != '}';) {
-        opts[i++] = fmt[index++];
-    }
-    // NOLINTNEXTLINE
-    append_single(arg, opts.data());
-    index++;
-}
-
 template <typename... Args>
-void StringBuilder::append(StringView fmt, const Args &...args) {
+void StringBuilder::append(FormatString<std::remove_cvref_t<Args>...> fmt, const Args &...args) {
     std::size_t index = 0;
-    (append_part(fmt, index, args), ...);
-    m_buffer.extend(codespy::make_span(fmt.begin() + index, fmt.length() - index));
+    auto append_part = [&](const auto &arg) {
+        const auto &segment = fmt.segment(index++);
+        m_buffer.extend(segment.literal);
+        append_single(arg, segment.opts.data());
+    };
+    (append_part(args), ...);
+    m_buffer.extend(fmt.trailing());
 }
 
 } // namespace codespy
@@ -2,6 +2,7 @@
 
 #include <cstddef>
 #include <type_traits>
+#include <utility>
 
 namespace codespy {
 namespace detail {
@@ -30,11 +31,11 @@ struct AlignedStorage {
 
     template <typename... Args>
     void emplace(Args &&...args) {
-        new (data) T(forward<Args>(args)...);
+        new (data) T(std::forward<Args>(args)...);
     }
 
     void set(const T &value) { new (data) T(value); }
-    void set(T &&value) { new (data) T(move(value)); }
+    void set(T &&value) { new (data) T(std::move(value)); }
     void release() { get().~T(); }
 
     T &get() { return *__builtin_launder(reinterpret_cast<T *>(data)); }
@@ -128,11 +129,6 @@ inline constexpr auto &operator^=(auto &lhs, auto rhs) {
     return lhs = (lhs ^ rhs);
 }
 
-inline std::size_t hash_combine(std::size_t lhs, std::size_t rhs) {
-    lhs ^= rhs + 0x9e3779b9 + (lhs << 6u) + (lhs >> 2u);
-    return lhs;
-}
-
 [[noreturn]] inline void unreachable() {
 #ifdef __GNUC__
     __builtin_unreachable();
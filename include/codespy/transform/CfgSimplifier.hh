@@ -2,8 +2,10 @@
 
 namespace codespy::ir {
 
+class DominanceInfo;
 class Function;
 
-void simplify_cfg(Function *function);
+// If dom_info is given, it is kept up to date with any changes made to the CFG.
+void simplify_cfg(Function *function, DominanceInfo *dom_info = nullptr);
 
 } // namespace codespy::ir
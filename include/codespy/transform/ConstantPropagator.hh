@@ -0,0 +1,20 @@
+#pragma once
+
+namespace codespy::ir {
+
+class DominanceInfo;
+class Function;
+
+struct PropagateConstantsStats {
+    // Number of instructions replaced by a constant.
+    unsigned folded_inst_count{0};
+    // Number of blocks found to never execute.
+    unsigned dead_block_count{0};
+};
+
+// Sparse conditional constant propagation. Instructions which always produce the same constant are replaced by it, and
+// branches which always go the same way are folded by running simplify_cfg afterwards. If dom_info is given, it is kept
+// up to date with any changes made to the CFG.
+PropagateConstantsStats propagate_constants(Function *function, DominanceInfo *dom_info = nullptr);
+
+} // namespace codespy::ir
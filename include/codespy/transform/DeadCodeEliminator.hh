@@ -0,0 +1,25 @@
+#pragma once
+
+namespace codespy::ir {
+
+class Function;
+
+enum class DceMode {
+    // Remove instructions with no uses, and then any operands which become unused as a result.
+    UseCount,
+    // Assume everything is dead until proven live by a side effecting instruction. Slower, but also catches cycles of
+    // PHIs which only use each other.
+    Aggressive,
+};
+
+struct DceStats {
+    // Number of non-PHI instructions removed.
+    unsigned removed_inst_count{0};
+    // Number of PHIs removed.
+    unsigned removed_phi_count{0};
+};
+
+// Removes side effect free instructions whose results are unused.
+DceStats eliminate_dead_code(Function *function, DceMode mode = DceMode::UseCount);
+
+} // namespace codespy::ir
@@ -4,6 +4,8 @@ namespace codespy::ir {
 
 class Function;
 
+// Removes exception handler edges from blocks which can't throw, and splits off the non-throwing tail of a block where
+// it would otherwise pollute the handler's incoming state. Must be run before locals are promoted.
 void prune_exceptions(Function *function);
 
 } // namespace codespy::ir
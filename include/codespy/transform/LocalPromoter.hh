@@ -2,8 +2,25 @@
 
 namespace codespy::ir {
 
+class CfgSnapshot;
+class DominanceInfo;
 class Function;
+class LocalLiveness;
 
-void promote_locals(Function *function);
+struct PromoteLocalsStats {
+    // Number of PHIs minimal SSA would need, i.e. the sum of the iterated dominance frontier sizes.
+    unsigned minimal_phi_count{0};
+    // Number of PHIs actually inserted after pruning those for locals which aren't live.
+    unsigned pruned_phi_count{0};
+    // Number of inserted PHIs which were then removed for only merging a single value.
+    unsigned trivial_phi_count{0};
+};
+
+PromoteLocalsStats promote_locals(Function *function);
+PromoteLocalsStats promote_locals(Function *function, const DominanceInfo &dom_info);
+PromoteLocalsStats promote_locals(Function *function, const CfgSnapshot &cfg, const DominanceInfo &dom_info);
+// As above, with liveness taken from the caller, e.g. a cached analysis. It must be computed from the same snapshot.
+PromoteLocalsStats promote_locals(Function *function, const CfgSnapshot &cfg, const DominanceInfo &dom_info,
+                                  const LocalLiveness &liveness);
 
 } // namespace codespy::ir
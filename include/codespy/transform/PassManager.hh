@@ -0,0 +1,67 @@
+#pragma once
+
+#include <codespy/container/Vector.hh>
+#include <codespy/ir/AnalysisManager.hh>
+#include <codespy/support/Result.hh>
+#include <codespy/support/StringView.hh>
+
+#include <chrono>
+
+namespace codespy::ir {
+
+class Function;
+
+enum class OptLevel {
+    // The raw output of the frontend.
+    O0,
+    // Cheap CFG cleanup only, locals stay in memory.
+    O1,
+    // Full SSA construction and cleanup.
+    O2,
+};
+
+enum class PipelineError {
+    UnknownPass,
+};
+
+struct PassStatistic {
+    StringView name;
+    unsigned value;
+};
+
+struct Pass {
+    StringView name;
+    // Returns the analyses which are still valid after the pass has run. Any interesting numbers about what the pass
+    // did can be reported by pushing to statistics.
+    PreservedAnalyses (*run)(Function *function, AnalysisManager &analyses, Vector<PassStatistic> &statistics);
+};
+
+struct PassRecord {
+    StringView pass_name;
+    std::chrono::nanoseconds duration;
+    Vector<PassStatistic> statistics;
+};
+
+class PassManager {
+    Vector<Pass> m_passes;
+
+public:
+    void add_pass(const Pass &pass) { m_passes.push(pass); }
+
+    // Runs every pass in order on the function. The time taken by each pass, including computing any analyses it
+    // requested, is returned along with its statistics. Functions without a body are skipped.
+    Vector<PassRecord> run(Function *function) const;
+
+    const Vector<Pass> &passes() const { return m_passes; }
+};
+
+// Looks up a builtin pass by name, e.g. "simplify-cfg". Returns nullptr if there is no such pass.
+const Pass *find_pass(StringView name);
+
+// Returns the pipeline spec for the given optimisation level.
+StringView pipeline_spec(OptLevel level);
+
+// Appends the passes from a comma separated list of pass names, e.g. "simplify-cfg,promote-locals".
+Result<void, PipelineError> parse_pipeline(StringView spec, PassManager &pass_manager);
+
+} // namespace codespy::ir
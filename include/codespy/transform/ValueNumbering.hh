@@ -0,0 +1,51 @@
+#pragma once
+
+#include <codespy/container/Vector.hh>
+#include <codespy/ir/Instruction.hh>
+
+#include <cstddef>
+#include <cstdint>
+
+namespace codespy::ir {
+
+class DominanceInfo;
+class Function;
+class Type;
+
+// Dominator tree scoped global value numbering. A pure instruction is replaced if an instruction with the same opcode,
+// type, attributes and operands dominates it. The table is emptied by the walk itself, so keeping one object around for
+// many functions avoids reallocating it each time.
+class ValueNumbering {
+    struct Key {
+        Opcode opcode;
+        Type *type;
+        std::uintptr_t attribute;
+        Value *lhs;
+        Value *rhs;
+
+        bool operator==(const Key &) const = default;
+    };
+
+    struct Entry {
+        Key key;
+        Instruction *inst{nullptr};
+    };
+
+    // Open addressed with linear probing. Entries are only ever removed in the reverse order of insertion when leaving
+    // a dominator subtree, which never breaks a probe sequence, so no tombstones are needed.
+    Vector<Entry> m_table;
+    Vector<std::uint32_t> m_inserted_slots;
+    unsigned m_replaced_count{0};
+
+    static bool make_key(Instruction *inst, Key &key);
+    static std::size_t hash_key(const Key &key);
+    void ensure_capacity(std::uint32_t inst_count);
+    void number_block(BasicBlock *block);
+    void pop_scope(std::uint32_t scope_size);
+
+public:
+    // Returns the number of instructions replaced.
+    unsigned run(Function *function, const DominanceInfo &dom_info);
+};
+
+} // namespace codespy::ir
@@ -184,26 +184,32 @@ void Frontend::visit_method(AccessFlags access_flags, StringView name, StringVie
 
 void Frontend::visit_code(CodeAttribute &code) {
     m_stack.ensure_capacity(code.max_stack());
-    m_local_map.reserve(code.max_locals());
+    m_local_map.ensure_capacity(code.max_locals());
 
     struct JumpTargetVisitor final : public CodeVisitor {
-        std::unordered_map<std::int32_t, BlockInfo> &block_map;
+        HashMap<std::int32_t, BlockInfo> &block_map;
+        bool entry_is_target{false};
 
-        JumpTargetVisitor(std::unordered_map<std::int32_t, BlockInfo> &block_map) : block_map(block_map) {}
+        JumpTargetVisitor(HashMap<std::int32_t, BlockInfo> &block_map) : block_map(block_map) {}
 
-        void visit_goto(std::int32_t offset) override { block_map[offset]; }
-        void visit_if_compare(CompareOp, std::int32_t true_offset, CompareRhs) override { block_map[true_offset]; }
+        void add_target(std::int32_t pc) {
+            block_map[pc];
+            entry_is_target |= pc == 0;
+        }
+
+        void visit_goto(std::int32_t offset) override { add_target(offset); }
+        void visit_if_compare(CompareOp, std::int32_t true_offset, CompareRhs) override { add_target(true_offset); }
         void visit_table_switch(std::int32_t, std::int32_t, std::int32_t default_pc,
                                 Span<std::int32_t> table) override {
-            block_map[default_pc];
+            add_target(default_pc);
             for (std::int32_t pc : table) {
-                block_map[pc];
+                add_target(pc);
             }
         }
         void visit_lookup_switch(std::int32_t default_pc, Span<std::pair<std::int32_t, std::int32_t>> table) override {
-            block_map[default_pc];
+            add_target(default_pc);
             for (const auto &[key, case_pc] : table) {
-                block_map[case_pc];
+                add_target(case_pc);
             }
         }
     } visitor(m_block_map);
@@ -211,6 +217,25 @@ void Frontend::visit_code(CodeAttribute &code) {
         pc += CODESPY_EXPECT(code.parse_inst(pc, visitor));
     }
 
+    auto copy_arguments = [this] {
+        for (std::uint32_t i = 0; auto *argument : m_function->arguments()) {
+            auto *local = materialise_local(i++);
+            if (argument->type() == m_context.int_type(64) || argument->type() == m_context.double_type()) {
+                // Longs and doubles take up two local slots in bytecode.
+                i++;
+            }
+            m_block->append<ir::StoreInst>(local, argument);
+        }
+    };
+
+    // The entry block can't have any predecessors, so if the first instruction is a jump target (e.g. a loop at the
+    // very start of the method), emit a separate entry block.
+    if (visitor.entry_is_target) {
+        m_block = m_function->append_block();
+        copy_arguments();
+        m_block->append<ir::BranchInst>(materialise_block(0, /*save_stack*/ false));
+    }
+
     m_queue.push_front(0);
     while (!m_queue.empty()) {
         auto pc = m_queue.front();
@@ -238,15 +263,8 @@ void Frontend::visit_code(CodeAttribute &code) {
         }
 
         // Copy arguments to locals.
-        if (pc == 0) {
-            for (std::uint32_t i = 0; auto *argument : m_function->arguments()) {
-                auto *local = materialise_local(i++);
-                if (argument->type() == m_context.int_type(64) || argument->type() == m_context.double_type()) {
-                    // Longs and doubles take up two local slots in bytecode.
-                    i++;
-                }
-                m_block->append<ir::StoreInst>(local, argument);
-            }
+        if (pc == 0 && !visitor.entry_is_target) {
+            copy_arguments();
         }
 
         do {
@@ -396,8 +414,7 @@ void Frontend::visit_new(StringView descriptor, std::uint8_t dimensions) {
     assert(dimensions <= type_dimensions);
 #endif
 
-    // TODO(small-vector)
-    Vector<ir::Value *> counts(dimensions);
+    SmallVector<ir::Value *, 4> counts(dimensions);
     for (std::uint32_t i = counts.size(); i > 0; i--) {
         counts[i - 1] = m_stack.take_last();
     }
@@ -434,7 +451,7 @@ void Frontend::visit_invoke(InvokeKind kind, StringView owner, StringView name,
     }
     auto *function = ensure_class(owner)->ensure_method(name, parse_function_type(descriptor, this_type));
 
-    Vector<ir::Value *> arguments(function->function_type()->parameter_types().size());
+    SmallVector<ir::Value *, 8> arguments(function->function_type()->parameter_types().size());
     for (std::uint32_t i = arguments.size(); i > 0; i--) {
         arguments[i - 1] = m_stack.take_last();
     }
@@ -676,7 +693,7 @@ void Frontend::emit_switch(std::size_t case_count, std::int32_t default_pc, F ne
     auto *key_type = static_cast<ir::IntType *>(key_value->type());
     auto *default_target = materialise_block(default_pc, /*save_stack*/ true);
 
-    Vector<std::pair<ir::Value *, ir::BasicBlock *>> targets(case_count);
+    SmallVector<std::pair<ir::Value *, ir::BasicBlock *>, 16> targets(case_count);
     for (std::size_t i = 0; i < case_count; i++) {
         const auto [case_value, offset] = next_case();
         targets[i] = std::make_pair(m_context.constant_int(key_type, case_value),
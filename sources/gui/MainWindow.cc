@@ -4,6 +4,9 @@
 #include <codespy/gui/IrHighlighter.hh>
 #include <codespy/gui/TextEdit.hh>
 #include <codespy/gui/TreeModel.hh>
+#include <codespy/ir/Dumper.hh>
+#include <codespy/support/StringBuilder.hh>
+#include <codespy/transform/PassManager.hh>
 
 #include <QHBoxLayout>
 #include <QLabel>
@@ -15,9 +18,40 @@
 #include <QTextDocument>
 #include <QTreeView>
 
+#include <functional>
+#include <utility>
+
 namespace codespy::gui {
+namespace {
+
+// Runs the full pipeline on the methods of a class, then hands the new IR text to the done callback.
+class UpgradeTask final : public QRunnable {
+    Vector<ir::Function *> m_methods;
+    const ir::PassManager &m_pipeline;
+    std::function<void(QString)> m_done;
+
+public:
+    UpgradeTask(Vector<ir::Function *> &&methods, const ir::PassManager &pipeline, std::function<void(QString)> done)
+        : m_methods(std::move(methods)), m_pipeline(pipeline), m_done(std::move(done)) {}
+
+    void run() override {
+        StringBuilder sb;
+        for (auto *function : m_methods) {
+            m_pipeline.run(function);
+            sb.append(ir::dump_code(function));
+            sb.append('\n');
+        }
+        const auto ir_text = sb.build();
+        m_done(QString::fromUtf8(ir_text.data(), ir_text.length()));
+    }
+};
+
+} // namespace
+
+MainWindow::MainWindow(Vector<ClassData> &&classes, const ir::PassManager *upgrade_pipeline)
+    : m_upgrade_pipeline(upgrade_pipeline) {
+    m_upgrade_pool.setMaxThreadCount(1);
 
-MainWindow::MainWindow(Vector<ClassData> &&classes) {
     auto *file_menu = menuBar()->addMenu("&File");
 
     auto *open_action = file_menu->addAction("&Open");
@@ -51,12 +85,33 @@ MainWindow::MainWindow(Vector<ClassData> &&classes) {
     resize(1024, 768);
 
     QObject::connect(tree_view->selectionModel(), &QItemSelectionModel::currentRowChanged,
-                     [=](const QModelIndex &current, const QModelIndex &) {
+                     [=, this](const QModelIndex &current, const QModelIndex &) {
                          if (!current.isValid()) {
                              return;
                          }
                          ir_editor->setPlainText(tree_model->ir_text(current.internalId()));
                          bc_editor->setPlainText(tree_model->bc_text(current.internalId()));
+
+                         auto &class_data = tree_model->class_data(current.internalId());
+                         if (m_upgrade_pipeline == nullptr || class_data.pending_methods.empty()) {
+                             return;
+                         }
+
+                         // Show the cheap output straight away and swap in the fully optimised output once ready.
+                         const auto row = current.internalId();
+                         auto done = [=, this](QString ir_text) {
+                             QMetaObject::invokeMethod(
+                                 this,
+                                 [=] {
+                                     tree_model->class_data(row).ir_text = ir_text;
+                                     if (tree_view->currentIndex().internalId() == row) {
+                                         ir_editor->setPlainText(ir_text);
+                                     }
+                                 },
+                                 Qt::QueuedConnection);
+                         };
+                         m_upgrade_pool.start(
+                             new UpgradeTask(std::move(class_data.pending_methods), *m_upgrade_pipeline, done));
                      });
 }
 
@@ -0,0 +1,33 @@
+#include <codespy/ir/AnalysisManager.hh>
+
+#include <codespy/ir/CfgSnapshot.hh>
+#include <codespy/ir/Dominance.hh>
+#include <codespy/ir/Liveness.hh>
+
+namespace codespy::ir {
+
+CfgSnapshot AnalysisTraits<CfgSnapshot>::compute(AnalysisManager &analyses) {
+    return CfgSnapshot(analyses.function());
+}
+
+DominanceInfo AnalysisTraits<DominanceInfo>::compute(AnalysisManager &analyses) {
+    return ir::compute_dominance(analyses.get<CfgSnapshot>());
+}
+
+LocalLiveness AnalysisTraits<LocalLiveness>::compute(AnalysisManager &analyses) {
+    return LocalLiveness(analyses.get<CfgSnapshot>());
+}
+
+void AnalysisManager::invalidate(PreservedAnalyses preserved) {
+    for (std::size_t i = 0; i < m_results.size(); i++) {
+        if (!preserved.is_preserved(static_cast<AnalysisKind>(i))) {
+            m_results[i].clear();
+        }
+    }
+    // Liveness refers to the cached CFG snapshot rather than holding its own copy.
+    if (!m_results[codespy::to_underlying(AnalysisKind::CfgSnapshot)]) {
+        m_results[codespy::to_underlying(AnalysisKind::Liveness)].clear();
+    }
+}
+
+} // namespace codespy::ir
@@ -2,6 +2,10 @@
 
 #include <codespy/ir/Context.hh>
 #include <codespy/ir/Function.hh>
+#include <codespy/ir/Instructions.hh>
+#include <codespy/support/Span.hh>
+
+#include <cassert>
 
 namespace codespy::ir {
 
@@ -20,10 +24,56 @@ void BasicBlock::remove(Instruction *inst) {
     m_insts.erase(iterator(inst));
 }
 
+void BasicBlock::remove(Span<Instruction *const> insts) {
+    for (auto *inst : insts) {
+        assert(inst->parent() == this && !inst->has_uses());
+        if (ir::value_is<ExceptionHandler>(inst)) {
+            m_handlers.unlink(List<ExceptionHandler>::iterator(inst));
+        } else {
+            m_insts.unlink(iterator(inst));
+        }
+    }
+    for (auto *inst : insts) {
+        inst->destroy();
+    }
+}
+
 void BasicBlock::remove_from_parent() {
     m_parent->remove_block(this);
 }
 
+void BasicBlock::splice(iterator before, BasicBlock *from) {
+    for (auto *inst : from->m_insts) {
+        inst->m_parent = this;
+    }
+    m_insts.splice(before, from->m_insts);
+}
+
+BasicBlock *BasicBlock::split(iterator at) {
+    auto *block = m_parent->append_block();
+    for (auto it = at; it != end(); ++it) {
+        it->m_parent = block;
+    }
+    block->m_insts.splice(block->end(), m_insts, at, end());
+    append<BranchInst>(block);
+
+    // Any PHIs in the successors now have an incoming edge from the new block instead.
+    for (unsigned i = 0; i < block->terminator()->successor_count(); i++) {
+        for (auto *inst : *block->terminator()->successor(i)) {
+            auto *phi = value_cast<PhiInst>(inst);
+            if (phi == nullptr) {
+                break;
+            }
+            for (unsigned j = 0; j < phi->incoming_count(); j++) {
+                if (phi->incoming_block(j) == this) {
+                    phi->set_incoming(j, block, phi->incoming_value(j));
+                }
+            }
+        }
+    }
+    return block;
+}
+
 BasicBlock *BasicBlock::successor(unsigned index) const {
     const auto successor_count = terminator()->successor_count();
     if (index < successor_count) {
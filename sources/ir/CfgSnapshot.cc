@@ -0,0 +1,104 @@
+#include <codespy/ir/CfgSnapshot.hh>
+
+#include <codespy/ir/BasicBlock.hh>
+#include <codespy/ir/Function.hh>
+#include <codespy/ir/Instructions.hh>
+
+#include <utility>
+
+namespace codespy::ir {
+namespace {
+
+// Calls callback for every successor edge of the block, in the same order as BasicBlock::successor, but without
+// re-walking the handler list for each one.
+template <typename F>
+void for_each_succ(BasicBlock *block, F callback) {
+    auto *terminator = block->terminator();
+    for (unsigned i = 0; i < terminator->successor_count(); i++) {
+        callback(terminator->successor(i));
+    }
+    for (auto *handler : block->handlers()) {
+        callback(handler->target());
+    }
+}
+
+} // namespace
+
+CfgSnapshot::CfgSnapshot(Function *function) : m_function(function) {
+    if (function->blocks().empty()) {
+        // No body, e.g. an abstract method.
+        m_succ_offsets.push(0);
+        m_pred_offsets.push(0);
+        return;
+    }
+
+    // Number blocks in postorder with an explicit stack to avoid recursion on deep CFGs. The successors of each block
+    // are gathered into a flat list when it's first visited, so the terminator and handlers are only walked once.
+    struct Frame {
+        BasicBlock *block;
+        std::uint32_t succ_begin;
+        std::uint32_t next_succ;
+        std::uint32_t succ_end;
+    };
+    Vector<BasicBlock *> flat_succs;
+    Vector<Frame> stack;
+    Vector<Frame> post_order;
+    auto push = [&](BasicBlock *block) {
+        const auto succ_begin = flat_succs.size();
+        for_each_succ(block, [&](BasicBlock *succ) {
+            flat_succs.push(succ);
+        });
+        stack.push(Frame{block, succ_begin, succ_begin, flat_succs.size()});
+    };
+    m_ids.emplace(function->entry_block(), 0);
+    push(function->entry_block());
+    while (!stack.empty()) {
+        auto &frame = stack.last();
+        if (frame.next_succ < frame.succ_end) {
+            auto *succ = flat_succs[frame.next_succ++];
+            if (m_ids.emplace(succ, 0).second) {
+                push(succ);
+            }
+            continue;
+        }
+        post_order.push(frame);
+        stack.pop();
+    }
+
+    const auto block_count = post_order.size();
+    m_blocks.ensure_capacity(block_count);
+    for (std::uint32_t i = block_count; i > 0; i--) {
+        m_ids[post_order[i - 1].block] = m_blocks.size();
+        m_blocks.push(post_order[i - 1].block);
+    }
+
+    // Successors, in block id order.
+    m_succ_offsets.ensure_capacity(block_count + 1);
+    m_succs.ensure_capacity(flat_succs.size());
+    for (std::uint32_t i = block_count; i > 0; i--) {
+        const auto &frame = post_order[i - 1];
+        m_succ_offsets.push(m_succs.size());
+        for (std::uint32_t j = frame.succ_begin; j < frame.succ_end; j++) {
+            m_succs.push(m_ids.at(flat_succs[j]));
+        }
+    }
+    m_succ_offsets.push(m_succs.size());
+
+    // Predecessors, by transposing the successor lists with a counting sort.
+    m_pred_offsets.ensure_size(block_count + 1, 0u);
+    for (auto succ : m_succs) {
+        m_pred_offsets[succ + 1]++;
+    }
+    for (std::uint32_t i = 0; i < block_count; i++) {
+        m_pred_offsets[i + 1] += m_pred_offsets[i];
+    }
+    Vector<std::uint32_t> insert_positions(m_pred_offsets.begin(), m_pred_offsets.end() - 1);
+    m_preds.ensure_size(m_succs.size(), 0u);
+    for (std::uint32_t block = 0; block < block_count; block++) {
+        for (auto succ : succs(block)) {
+            m_preds[insert_positions[succ]++] = block;
+        }
+    }
+}
+
+} // namespace codespy::ir
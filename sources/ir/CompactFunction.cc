@@ -0,0 +1,292 @@
+#include <codespy/ir/CompactFunction.hh>
+
+#include <codespy/container/HashMap.hh>
+#include <codespy/ir/BasicBlock.hh>
+#include <codespy/ir/Function.hh>
+#include <codespy/ir/Instructions.hh>
+#include <codespy/ir/Java.hh>
+#include <codespy/support/Enum.hh>
+
+#include <utility>
+
+// Instruction attributes:
+//   Binary, Compare, Monitor: the operator.
+//   Call: whether it's an invokespecial.
+//   InstanceOf: the index of the checked type in the attribute types.
+//   JavaCompare: the index of the operand type in the attribute types, shifted left by one, with greater_on_nan in the
+//   lowest bit.
+// Everything else is derived from the opcode, type and operand count.
+
+namespace codespy::ir {
+namespace {
+
+void clear_body(Function *function) {
+    // Drop every operand first so that blocks and locals can be deleted in any order.
+    for (auto *block : function->blocks()) {
+        for (auto *handler : block->handlers()) {
+            handler->drop_operands();
+        }
+        for (auto *inst : *block) {
+            inst->drop_operands();
+        }
+    }
+    while (!function->blocks().empty()) {
+        function->remove_block(function->blocks().first());
+    }
+    function->remove_locals();
+}
+
+} // namespace
+
+CompactFunction::CompactFunction(Function *function) : m_function(function) {
+    // Number blocks and instructions up front, since operands may refer forward.
+    HashMap<Value *, std::uint32_t> ids;
+    std::uint32_t block_count = 0;
+    std::uint32_t inst_count = 0;
+    std::uint32_t handler_count = 0;
+    for (auto *block : function->blocks()) {
+        ids.emplace(block, block_count++);
+        for (auto *inst : *block) {
+            ids.emplace(inst, inst_count++);
+        }
+        handler_count += block->handlers().size_slow();
+    }
+    Vector<std::uint32_t> local_ids;
+    local_ids.ensure_size(function->local_count(), 0u);
+    for (auto *local : function->locals()) {
+        local_ids[local->index()] = m_local_types.size();
+        m_local_types.push(local->type());
+    }
+
+    HashMap<Value *, std::uint32_t> shared_ids;
+    HashMap<Type *, std::uint32_t> attribute_type_ids;
+    auto compact_value = [&](Value *value) {
+        if (value == nullptr) {
+            return CompactValue();
+        }
+        switch (value->kind()) {
+        case ValueKind::Argument:
+            return CompactValue(CompactValueKind::Argument, static_cast<Argument *>(value)->index());
+        case ValueKind::BasicBlock:
+            return CompactValue(CompactValueKind::Block, ids.at(value));
+        case ValueKind::Instruction:
+            return CompactValue(CompactValueKind::Instruction, ids.at(value));
+        case ValueKind::Local:
+            return CompactValue(CompactValueKind::Local, local_ids[static_cast<Local *>(value)->index()]);
+        default:
+            assert(!value->tracks_uses());
+            const auto [it, inserted] = shared_ids.emplace(value, m_shared_values.size());
+            if (inserted) {
+                m_shared_values.push(value);
+            }
+            return CompactValue(CompactValueKind::Shared, it->second);
+        }
+    };
+    auto attribute_type = [&](Type *type) {
+        const auto [it, inserted] = attribute_type_ids.emplace(type, m_attribute_types.size());
+        if (inserted) {
+            m_attribute_types.push(type);
+        }
+        return it->second;
+    };
+
+    m_inst_offsets.ensure_capacity(block_count + 1);
+    m_handler_offsets.ensure_capacity(block_count + 1);
+    m_handler_types.ensure_capacity(handler_count);
+    m_handler_targets.ensure_capacity(handler_count);
+    m_opcodes.ensure_capacity(inst_count);
+    m_types.ensure_capacity(inst_count);
+    m_parents.ensure_capacity(inst_count);
+    m_attributes.ensure_capacity(inst_count);
+    m_operand_offsets.ensure_capacity(inst_count + 1);
+    for (std::uint32_t block_id = 0; auto *block : function->blocks()) {
+        m_inst_offsets.push(m_opcodes.size());
+        m_handler_offsets.push(m_handler_types.size());
+        for (auto *handler : block->handlers()) {
+            m_handler_types.push(handler->type());
+            m_handler_targets.push(ids.at(handler->target()));
+        }
+        for (auto *inst : *block) {
+            std::uint32_t attribute = 0;
+            if (const auto *binary = value_cast<BinaryInst>(inst)) {
+                attribute = codespy::to_underlying(binary->op());
+            } else if (const auto *call = value_cast<CallInst>(inst)) {
+                attribute = call->is_invoke_special() ? 1 : 0;
+            } else if (const auto *compare = value_cast<CompareInst>(inst)) {
+                attribute = codespy::to_underlying(compare->op());
+            } else if (const auto *instance_of = value_cast<InstanceOfInst>(inst)) {
+                attribute = attribute_type(instance_of->check_type());
+            } else if (const auto *java_compare = value_cast<JavaCompareInst>(inst)) {
+                attribute = attribute_type(java_compare->operand_type()) << 1;
+                attribute |= java_compare->greater_on_nan() ? 1 : 0;
+            } else if (const auto *monitor = value_cast<MonitorInst>(inst)) {
+                attribute = codespy::to_underlying(monitor->op());
+            }
+            m_opcodes.push(inst->opcode());
+            m_types.push(inst->type());
+            m_parents.push(block_id);
+            m_attributes.push(attribute);
+            m_operand_offsets.push(m_operands.size());
+            for (unsigned i = 0; i < inst->operand_count(); i++) {
+                m_operands.push(compact_value(inst->operand(i)));
+            }
+        }
+        block_id++;
+    }
+    m_inst_offsets.push(m_opcodes.size());
+    m_handler_offsets.push(m_handler_types.size());
+    m_operand_offsets.push(m_operands.size());
+}
+
+void CompactFunction::write_back() const {
+    auto *function = m_function;
+    clear_body(function);
+
+    Vector<BasicBlock *> blocks;
+    blocks.ensure_capacity(block_count());
+    for (std::uint32_t i = 0; i < block_count(); i++) {
+        blocks.push(function->append_block());
+    }
+    Vector<Local *> locals;
+    locals.ensure_capacity(local_count());
+    for (auto *type : m_local_types) {
+        locals.push(function->append_local(type));
+    }
+    Vector<Argument *> arguments;
+    for (auto *argument : function->arguments()) {
+        arguments.push(argument);
+    }
+
+    // Instructions are first created with the right shape but null operands, which are then all filled in at once
+    // afterwards, since they may refer to instructions later on.
+    Vector<Instruction *> insts;
+    insts.ensure_capacity(inst_count());
+    Vector<Value *> null_operands;
+    Vector<std::pair<Value *, BasicBlock *>> null_cases;
+    for (std::uint32_t block_id = 0; block_id < block_count(); block_id++) {
+        auto *block = blocks[block_id];
+        for (auto handler = handler_begin(block_id); handler < handler_end(block_id); handler++) {
+            block->add_handler(m_handler_types[handler], blocks[m_handler_targets[handler]]);
+        }
+        for (auto inst = inst_begin(block_id); inst < inst_end(block_id); inst++) {
+            auto *type = m_types[inst];
+            const auto attribute = m_attributes[inst];
+            const auto operand_count = m_operand_offsets[inst + 1] - m_operand_offsets[inst];
+            null_operands.ensure_size(operand_count, nullptr);
+            switch (m_opcodes[inst]) {
+            case Opcode::ArrayLength:
+                insts.push(block->append<ArrayLengthInst>(nullptr));
+                break;
+            case Opcode::Binary:
+                insts.push(block->append<BinaryInst>(type, static_cast<BinaryOp>(attribute), nullptr, nullptr));
+                break;
+            case Opcode::Branch:
+                if (operand_count == 1) {
+                    insts.push(block->append<BranchInst>(nullptr));
+                } else {
+                    insts.push(block->append<BranchInst>(nullptr, nullptr, nullptr));
+                }
+                break;
+            case Opcode::Call: {
+                // The callee is needed up front for the return type.
+                auto *callee = static_cast<Function *>(m_shared_values[operands(inst)[0].index()]);
+                auto *call = block->append<CallInst>(callee, null_operands.span().subspan(0, operand_count - 1));
+                call->set_is_invoke_special(attribute != 0);
+                insts.push(call);
+                break;
+            }
+            case Opcode::Cast:
+                insts.push(block->append<CastInst>(type, nullptr));
+                break;
+            case Opcode::Catch:
+                insts.push(block->append<CatchInst>(type));
+                break;
+            case Opcode::Compare:
+                insts.push(block->append<CompareInst>(static_cast<CompareOp>(attribute), nullptr, nullptr));
+                break;
+            case Opcode::ExceptionHandler:
+                codespy::unreachable();
+            case Opcode::InstanceOf:
+                insts.push(block->append<InstanceOfInst>(m_attribute_types[attribute], nullptr));
+                break;
+            case Opcode::JavaCompare:
+                insts.push(block->append<JavaCompareInst>(m_attribute_types[attribute >> 1], nullptr, nullptr,
+                                                          (attribute & 1) != 0));
+                break;
+            case Opcode::Load:
+                insts.push(block->append<LoadInst>(type, nullptr));
+                break;
+            case Opcode::LoadArray:
+                insts.push(block->append<LoadArrayInst>(type, nullptr, nullptr));
+                break;
+            case Opcode::LoadField:
+                insts.push(block->append<LoadFieldInst>(type, nullptr, nullptr));
+                break;
+            case Opcode::Monitor:
+                insts.push(block->append<MonitorInst>(static_cast<MonitorOp>(attribute), nullptr));
+                break;
+            case Opcode::Negate:
+                insts.push(block->append<NegateInst>(type, nullptr));
+                break;
+            case Opcode::New:
+                insts.push(block->append<NewInst>(type));
+                break;
+            case Opcode::NewArray:
+                insts.push(block->append<NewArrayInst>(type, null_operands.span().subspan(0, operand_count)));
+                break;
+            case Opcode::Phi:
+                insts.push(block->append<PhiInst>(operand_count / 2));
+                break;
+            case Opcode::Return:
+                // A void return has no operands, so use any non-null placeholder to get the operand count right.
+                insts.push(block->append<ReturnInst>(operand_count != 0 ? block : nullptr));
+                break;
+            case Opcode::Store:
+                insts.push(block->append<StoreInst>(nullptr, nullptr));
+                break;
+            case Opcode::StoreArray:
+                insts.push(block->append<StoreArrayInst>(nullptr, nullptr, nullptr));
+                break;
+            case Opcode::StoreField:
+                insts.push(block->append<StoreFieldInst>(nullptr, nullptr, nullptr));
+                break;
+            case Opcode::Switch: {
+                const auto case_count = (operand_count - 2) / 2;
+                null_cases.ensure_size(case_count, std::make_pair(nullptr, nullptr));
+                insts.push(block->append<SwitchInst>(nullptr, nullptr, null_cases.span().subspan(0, case_count)));
+                break;
+            }
+            case Opcode::Throw:
+                insts.push(block->append<ThrowInst>(nullptr));
+                break;
+            }
+        }
+    }
+
+    auto value = [&](CompactValue compact) -> Value * {
+        switch (compact.kind()) {
+        case CompactValueKind::None:
+            return nullptr;
+        case CompactValueKind::Instruction:
+            return insts[compact.index()];
+        case CompactValueKind::Argument:
+            return arguments[compact.index()];
+        case CompactValueKind::Local:
+            return locals[compact.index()];
+        case CompactValueKind::Block:
+            return blocks[compact.index()];
+        case CompactValueKind::Shared:
+            return m_shared_values[compact.index()];
+        }
+        codespy::unreachable();
+    };
+    for (std::uint32_t inst = 0; inst < inst_count(); inst++) {
+        for (unsigned i = 0; const auto &operand : operands(inst)) {
+            insts[inst]->set_operand(i++, value(operand));
+        }
+        // PHIs take their type from their incoming values.
+        insts[inst]->set_type(m_types[inst]);
+    }
+}
+
+} // namespace codespy::ir
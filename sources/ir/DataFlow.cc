@@ -0,0 +1,92 @@
+#include <codespy/ir/DataFlow.hh>
+
+#include <codespy/ir/CfgSnapshot.hh>
+
+namespace codespy::ir {
+namespace {
+
+using WordType = BitMatrix::WordType;
+
+void meet_into(Span<WordType> dst, Span<const WordType> src, DataFlowMeet meet) {
+    for (std::size_t i = 0; i < dst.size(); i++) {
+        dst[i] = meet == DataFlowMeet::Union ? dst[i] | src[i] : dst[i] & src[i];
+    }
+}
+
+} // namespace
+
+BitDataFlow::BitDataFlow(const CfgSnapshot &cfg, std::uint32_t fact_count, DataFlowDirection direction,
+                         DataFlowMeet meet)
+    : m_cfg(cfg), m_direction(direction), m_meet(meet), m_gen(cfg.block_count(), fact_count),
+      m_kill(cfg.block_count(), fact_count), m_boundary(1, fact_count), m_entry_sets(cfg.block_count(), fact_count),
+      m_exit_sets(cfg.block_count(), fact_count), m_pending(1, cfg.block_count()) {}
+
+void BitDataFlow::solve() {
+    const bool forward = m_direction == DataFlowDirection::Forward;
+    auto &meet_sets = forward ? m_entry_sets : m_exit_sets;
+    auto &result_sets = forward ? m_exit_sets : m_entry_sets;
+
+    // Start everything at the top of the lattice so that the first meet over a not yet visited neighbour is a no-op.
+    const auto block_count = m_cfg.block_count();
+    for (std::uint32_t block = 0; block < block_count; block++) {
+        if (m_meet == DataFlowMeet::Union) {
+            result_sets.clear_row(block);
+        } else {
+            result_sets.fill_row(block);
+        }
+    }
+
+    // The worklist is indexed by priority, which is the block id for forward problems and the reverse of it for
+    // backward ones. Each sweep picks up any block requeued at a higher priority, lower ones wait for the next sweep.
+    // The mapping is its own inverse.
+    auto to_block = [&](std::uint32_t priority) {
+        return forward ? priority : block_count - priority - 1;
+    };
+    m_pending.fill_row(0);
+    while (true) {
+        auto priority = m_pending.find_next(0, 0);
+        if (priority == block_count) {
+            break;
+        }
+        for (; priority < block_count; priority = m_pending.find_next(0, priority + 1)) {
+            m_pending.reset(0, priority);
+            const auto block = to_block(priority);
+            const auto sources = forward ? m_cfg.preds(block) : m_cfg.succs(block);
+            const auto dependents = forward ? m_cfg.succs(block) : m_cfg.preds(block);
+
+            auto meet_set = meet_sets.row_words(block);
+            const bool is_boundary = forward ? block == 0 : sources.empty();
+            if (is_boundary) {
+                const auto boundary = m_boundary.row_words(0);
+                for (std::size_t i = 0; i < meet_set.size(); i++) {
+                    meet_set[i] = boundary[i];
+                }
+            } else if (m_meet == DataFlowMeet::Union) {
+                meet_sets.clear_row(block);
+            } else {
+                meet_sets.fill_row(block);
+            }
+            for (auto source : sources) {
+                meet_into(meet_set, result_sets.row_words(source), m_meet);
+            }
+
+            const auto gen = m_gen.row_words(block);
+            const auto kill = m_kill.row_words(block);
+            auto result_set = result_sets.row_words(block);
+            WordType changed = 0;
+            for (std::size_t i = 0; i < result_set.size(); i++) {
+                const auto word = gen[i] | (meet_set[i] & ~kill[i]);
+                changed |= word ^ result_set[i];
+                result_set[i] = word;
+            }
+            if (changed == 0) {
+                continue;
+            }
+            for (auto dependent : dependents) {
+                m_pending.set(0, to_block(dependent));
+            }
+        }
+    }
+}
+
+} // namespace codespy::ir
@@ -1,11 +1,15 @@
 #include <codespy/ir/Dominance.hh>
 
+#include <codespy/container/BitVector.hh>
+#include <codespy/container/HashSet.hh>
 #include <codespy/ir/BasicBlock.hh>
 #include <codespy/ir/Cfg.hh>
+#include <codespy/ir/CfgSnapshot.hh>
 #include <codespy/ir/Function.hh>
 
-#include <unordered_map>
-#include <unordered_set>
+#include <algorithm>
+#include <queue>
+#include <utility>
 
 // Implementation of https://www.cs.rice.edu/~keith/Embed/dom.pdf
 // A node D dominates a node N if every path from the entry to N must go from D (considered strict if N != D)
@@ -17,19 +21,608 @@
 // If D is N's immediate dominator then every node in {Dom(N) - N} is also in Dom(D)
 
 namespace codespy::ir {
+namespace {
 
-bool DominanceInfo::dominates(BasicBlock *dominator, BasicBlock *block) const {
-    for (auto *idom = block; idom != nullptr; idom = m_idoms.at(idom)) {
-        if (idom == dominator) {
+// Above this many blocks the Semi-NCA algorithm is used over the iterative one.
+constexpr std::size_t k_semi_nca_threshold = 256;
+
+constexpr unsigned k_unnumbered = ~0u;
+
+// DFS numbering of arbitrary blocks, for when only part of the CFG is being visited.
+class BlockNumbering {
+    HashMap<BasicBlock *, unsigned> m_numbers;
+
+public:
+    bool assign(BasicBlock *block, unsigned number) { return m_numbers.emplace(block, number).second; }
+    unsigned lookup(BasicBlock *block) const {
+        auto it = m_numbers.find(block);
+        return it != m_numbers.end() ? it->second : k_unnumbered;
+    }
+};
+
+// DFS numbering of the blocks of a CFG snapshot, by block id.
+class SnapshotNumbering {
+    Vector<unsigned> m_numbers;
+
+public:
+    explicit SnapshotNumbering(std::uint32_t block_count) { m_numbers.ensure_size(block_count, k_unnumbered); }
+
+    bool assign(std::uint32_t id, unsigned number) {
+        if (m_numbers[id] != k_unnumbered) {
+            return false;
+        }
+        m_numbers[id] = number;
+        return true;
+    }
+    unsigned lookup(std::uint32_t id) const { return m_numbers[id]; }
+};
+
+// Semi-NCA as described in "Finding Dominators in Practice" (Georgiadis, Werneck, Tarjan, Spyrou, Pinto). Semi-
+// dominators are computed as in Lengauer-Tarjan using path compression, but the immediate dominators are then found by
+// a nearest common ancestor walk up the partially built tree instead of a second pass over the buckets.
+// Nodes are either blocks or snapshot block ids, numbered by the matching numbering. The graph is given by the succs
+// and preds callables, and the DFS only descends into nodes accepted by filter. The result is the list of visited
+// nodes in preorder paired with the preorder index of their immediate dominator.
+template <typename Node, typename Numbering, typename Succs, typename Preds, typename Filter>
+Vector<std::pair<Node, unsigned>> run_semi_nca(Node root, Numbering &numbering, Succs succs, Preds preds,
+                                               Filter filter) {
+    struct NodeInfo {
+        Node block;
+        unsigned parent;
+        unsigned ancestor;
+        unsigned semi;
+        unsigned label;
+        unsigned idom;
+    };
+
+    // Number blocks in DFS preorder, using an explicit worklist of (block, parent number) pairs. Marking blocks on pop
+    // rather than push keeps the spanning tree a valid DFS tree.
+    Vector<NodeInfo> infos;
+    Vector<std::pair<Node, unsigned>> worklist;
+    worklist.push(std::make_pair(root, 0u));
+    while (!worklist.empty()) {
+        auto [block, parent] = worklist.take_last();
+        const auto number = infos.size();
+        if (!numbering.assign(block, number)) {
+            continue;
+        }
+        infos.push({
+            .block = block,
+            .parent = parent,
+            .ancestor = parent,
+            .semi = number,
+            .label = number,
+            .idom = parent,
+        });
+        for (auto succ : succs(block)) {
+            if (numbering.lookup(succ) == k_unnumbered && filter(succ)) {
+                worklist.push(std::make_pair(succ, number));
+            }
+        }
+    }
+
+    // Find the vertex with the minimum semidominator on the path to the root of the virtual forest, compressing the
+    // path as we go. Only vertices numbered at least last_linked have been linked into the forest.
+    Vector<unsigned> eval_stack;
+    auto eval = [&](unsigned number, unsigned last_linked) {
+        if (infos[number].ancestor < last_linked) {
+            return infos[number].label;
+        }
+        do {
+            eval_stack.push(number);
+            number = infos[number].ancestor;
+        } while (infos[number].ancestor >= last_linked);
+
+        unsigned root = number;
+        unsigned root_label = infos[root].label;
+        while (!eval_stack.empty()) {
+            number = eval_stack.take_last();
+            auto &info = infos[number];
+            info.ancestor = infos[root].ancestor;
+            if (infos[root_label].semi < infos[info.label].semi) {
+                info.label = root_label;
+            } else {
+                root_label = info.label;
+            }
+            root = number;
+        }
+        return infos[number].label;
+    };
+
+    // Compute semidominators in reverse preorder.
+    for (unsigned i = infos.size() - 1; i > 0; i--) {
+        auto &info = infos[i];
+        info.semi = info.parent;
+        for (auto pred : preds(info.block)) {
+            const auto pred_number = numbering.lookup(pred);
+            if (pred_number == k_unnumbered) {
+                // Unreachable or outside of the region being computed.
+                continue;
+            }
+            info.semi = std::min(info.semi, infos[eval(pred_number, i + 1)].semi);
+        }
+    }
+
+    // The immediate dominator is the nearest common ancestor of the parent and the semidominator.
+    for (unsigned i = 1; i < infos.size(); i++) {
+        auto &info = infos[i];
+        while (info.idom > info.semi) {
+            info.idom = infos[info.idom].idom;
+        }
+    }
+
+    Vector<std::pair<Node, unsigned>> result;
+    result.ensure_capacity(infos.size());
+    for (const auto &info : infos) {
+        result.push(std::make_pair(info.block, info.idom));
+    }
+    return result;
+}
+
+// Returns the immediate dominator of each reachable block in reverse postorder. Snapshot ids are already in reverse
+// postorder, so an immediate dominator always has a lower id than the blocks it dominates.
+Vector<std::pair<BasicBlock *, BasicBlock *>> compute_idoms_iterative(const CfgSnapshot &cfg) {
+    Vector<std::uint32_t> idoms;
+    idoms.ensure_size(cfg.block_count(), k_unnumbered);
+    idoms[0] = 0;
+
+    auto intersect = [&](std::uint32_t finger1, std::uint32_t finger2) {
+        while (finger1 != finger2) {
+            while (finger1 > finger2) {
+                finger1 = idoms[finger1];
+            }
+            while (finger2 > finger1) {
+                finger2 = idoms[finger2];
+            }
+        }
+        return finger1;
+    };
+
+    bool changed = false;
+    do {
+        // For all nodes in reverse postorder (excl. entry)
+        for (std::uint32_t id = 1; id < cfg.block_count(); id++) {
+            // For all other predecessors of block
+            auto new_idom = k_unnumbered;
+            for (auto pred : cfg.preds(id)) {
+                if (idoms[pred] == k_unnumbered) {
+                    continue;
+                }
+                new_idom = new_idom == k_unnumbered ? pred : intersect(pred, new_idom);
+            }
+            changed |= std::exchange(idoms[id], new_idom) != new_idom;
+        }
+    } while (std::exchange(changed, false));
+
+    Vector<std::pair<BasicBlock *, BasicBlock *>> result;
+    result.ensure_capacity(cfg.block_count());
+    result.push(std::make_pair(cfg.block(0), nullptr));
+    for (std::uint32_t id = 1; id < cfg.block_count(); id++) {
+        result.push(std::make_pair(cfg.block(id), cfg.block(idoms[id])));
+    }
+    return result;
+}
+
+Vector<std::pair<BasicBlock *, BasicBlock *>> compute_idoms_semi_nca(const CfgSnapshot &cfg) {
+    SnapshotNumbering numbering(cfg.block_count());
+    auto infos = run_semi_nca(
+        std::uint32_t(0), numbering,
+        [&](std::uint32_t id) {
+            return cfg.succs(id);
+        },
+        [&](std::uint32_t id) {
+            return cfg.preds(id);
+        },
+        [](std::uint32_t) {
             return true;
+        });
+
+    Vector<std::pair<BasicBlock *, BasicBlock *>> result;
+    result.ensure_capacity(infos.size());
+    result.push(std::make_pair(cfg.block(0), nullptr));
+    for (unsigned i = 1; i < infos.size(); i++) {
+        result.push(std::make_pair(cfg.block(infos[i].first), cfg.block(infos[infos[i].second].first)));
+    }
+    return result;
+}
+
+} // namespace
+
+// Applies a batch of updates one edge at a time. While an update is pending, the CFG is viewed as it was before the
+// change (pending insertions hidden, pending deletions still present), so that each step only ever sees a single edge
+// change against a tree that is valid for the viewed graph.
+// Insertions follow "Dynamic Dominators in Practice" (Georgiadis, Italiano, Laura, Santaroni) as used by LLVM, and
+// deletions rebuild the smallest affected subtree using Semi-NCA.
+class DominanceUpdater {
+    DominanceInfo &m_info;
+    Vector<CfgUpdate> m_pending;
+
+    void add_unique(Vector<BasicBlock *> &blocks, BasicBlock *block) const;
+    void remove(Vector<BasicBlock *> &blocks, BasicBlock *block) const;
+    Vector<BasicBlock *> succs(BasicBlock *block) const;
+    Vector<BasicBlock *> preds(BasicBlock *block) const;
+    void reparent(BasicBlock *block, BasicBlock *idom);
+    void update_levels(BasicBlock *root);
+
+    void insert_edge(BasicBlock *from, BasicBlock *to);
+    void insert_reachable(BasicBlock *from, BasicBlock *to);
+    void insert_unreachable(BasicBlock *from, BasicBlock *to);
+    void delete_edge(BasicBlock *from, BasicBlock *to);
+    bool has_proper_support(BasicBlock *block) const;
+    void delete_unreachable(BasicBlock *block);
+    void rebuild_subtree(BasicBlock *root);
+
+public:
+    DominanceUpdater(DominanceInfo &info, Span<const CfgUpdate> updates);
+
+    void run();
+};
+
+DominanceUpdater::DominanceUpdater(DominanceInfo &info, Span<const CfgUpdate> updates) : m_info(info) {
+    // Stored in reverse so that the next update can be popped off the end.
+    m_pending.ensure_capacity(updates.size());
+    for (std::size_t i = updates.size(); i > 0; i--) {
+        m_pending.push(updates[i - 1]);
+    }
+}
+
+void DominanceUpdater::add_unique(Vector<BasicBlock *> &blocks, BasicBlock *block) const {
+    if (std::find(blocks.begin(), blocks.end(), block) == blocks.end()) {
+        blocks.push(block);
+    }
+}
+
+void DominanceUpdater::remove(Vector<BasicBlock *> &blocks, BasicBlock *block) const {
+    auto *it = std::find(blocks.begin(), blocks.end(), block);
+    if (it != blocks.end()) {
+        std::swap(*it, blocks.last());
+        blocks.pop();
+    }
+}
+
+Vector<BasicBlock *> DominanceUpdater::succs(BasicBlock *block) const {
+    Vector<BasicBlock *> succs;
+    for (auto *succ : ir::succs_of(block)) {
+        add_unique(succs, succ);
+    }
+    for (const auto &update : m_pending) {
+        if (update.from != block) {
+            continue;
         }
-        if (idom == idom->parent()->entry_block()) {
-            return false;
+        if (update.kind == CfgUpdateKind::Insert) {
+            remove(succs, update.to);
+        } else {
+            add_unique(succs, update.to);
+        }
+    }
+    return succs;
+}
+
+Vector<BasicBlock *> DominanceUpdater::preds(BasicBlock *block) const {
+    Vector<BasicBlock *> preds;
+    for (auto *pred : ir::preds_of(block)) {
+        add_unique(preds, pred);
+    }
+    for (const auto &update : m_pending) {
+        if (update.to != block) {
+            continue;
+        }
+        if (update.kind == CfgUpdateKind::Insert) {
+            remove(preds, update.from);
+        } else {
+            add_unique(preds, update.from);
+        }
+    }
+    return preds;
+}
+
+void DominanceUpdater::reparent(BasicBlock *block, BasicBlock *idom) {
+    auto &node = m_info.m_nodes.at(block);
+    if (node.idom != nullptr) {
+        remove(m_info.m_nodes.at(node.idom).children, block);
+    }
+    node.idom = idom;
+    m_info.m_nodes.at(idom).children.push(block);
+}
+
+void DominanceUpdater::update_levels(BasicBlock *root) {
+    Vector<BasicBlock *> worklist;
+    worklist.push(root);
+    while (!worklist.empty()) {
+        auto *block = worklist.take_last();
+        auto &node = m_info.m_nodes.at(block);
+        node.level = m_info.m_nodes.at(node.idom).level + 1;
+        for (auto *child : node.children) {
+            worklist.push(child);
+        }
+    }
+}
+
+void DominanceUpdater::run() {
+    while (!m_pending.empty()) {
+        const auto update = m_pending.take_last();
+        if (update.kind == CfgUpdateKind::Insert) {
+            insert_edge(update.from, update.to);
+        } else {
+            delete_edge(update.from, update.to);
+        }
+    }
+}
+
+void DominanceUpdater::insert_edge(BasicBlock *from, BasicBlock *to) {
+    if (!m_info.is_reachable(from)) {
+        // Edges out of unreachable blocks don't affect dominance.
+        return;
+    }
+    if (!m_info.is_reachable(to)) {
+        insert_unreachable(from, to);
+        return;
+    }
+    insert_reachable(from, to);
+}
+
+void DominanceUpdater::insert_reachable(BasicBlock *from, BasicBlock *to) {
+    auto *nca = m_info.nearest_common_dominator(from, to);
+    if (nca == to || nca == m_info.idom(to)) {
+        // Nothing affected.
+        return;
+    }
+
+    // A block w is affected iff level(nca) + 1 < level(w) and there is a path from `to` to w on which every block has
+    // a level of at least level(w). All affected blocks become immediate children of nca. Blocks are visited deepest
+    // first so that each is only considered once.
+    const auto nca_level = m_info.m_nodes.at(nca).level;
+    std::priority_queue<std::pair<unsigned, BasicBlock *>> bucket;
+    HashSet<BasicBlock *> visited;
+    Vector<BasicBlock *> affected;
+    Vector<BasicBlock *> unaffected;
+    bucket.emplace(m_info.m_nodes.at(to).level, to);
+    visited.insert(to);
+    while (!bucket.empty()) {
+        auto [current_level, block] = bucket.top();
+        bucket.pop();
+        affected.push(block);
+        unaffected.push(block);
+        while (!unaffected.empty()) {
+            for (auto *succ : succs(unaffected.take_last())) {
+                const auto succ_level = m_info.m_nodes.at(succ).level;
+                if (succ_level <= nca_level + 1 || !visited.insert(succ)) {
+                    continue;
+                }
+                if (succ_level > current_level) {
+                    unaffected.push(succ);
+                } else {
+                    bucket.emplace(succ_level, succ);
+                }
+            }
+        }
+    }
+
+    for (auto *block : affected) {
+        reparent(block, nca);
+    }
+    for (auto *block : affected) {
+        update_levels(block);
+    }
+}
+
+void DominanceUpdater::insert_unreachable(BasicBlock *from, BasicBlock *to) {
+    // Discover the newly reachable region and compute its dominators with `to` as the root. Any edges leading back
+    // into the previously reachable part of the CFG are then inserted as normal.
+    Vector<std::pair<BasicBlock *, BasicBlock *>> connecting_edges;
+    BlockNumbering numbering;
+    auto infos = run_semi_nca(
+        to, numbering,
+        [this](BasicBlock *block) {
+            return succs(block);
+        },
+        [this](BasicBlock *block) {
+            return preds(block);
+        },
+        [&](BasicBlock *block) {
+            return !m_info.is_reachable(block);
+        });
+    for (auto [block, idom] : infos) {
+        for (auto *succ : succs(block)) {
+            if (m_info.is_reachable(succ)) {
+                connecting_edges.push(std::make_pair(block, succ));
+            }
+        }
+    }
+    for (auto [block, idom] : infos) {
+        m_info.set_idom(block, block == to ? from : infos[idom].first);
+    }
+    for (auto [edge_from, edge_to] : connecting_edges) {
+        insert_reachable(edge_from, edge_to);
+    }
+}
+
+void DominanceUpdater::delete_edge(BasicBlock *from, BasicBlock *to) {
+    if (!m_info.is_reachable(from) || !m_info.is_reachable(to)) {
+        return;
+    }
+    auto from_succs = succs(from);
+    if (std::find(from_succs.begin(), from_succs.end(), to) != from_succs.end()) {
+        // Another edge still exists.
+        return;
+    }
+
+    auto *nca = m_info.nearest_common_dominator(from, to);
+    if (nca == to) {
+        // Back edge to a dominator, removing it can't change anything.
+        return;
+    }
+
+    // If from wasn't the immediate dominator, there must be another path to `to` which doesn't go through from.
+    if (m_info.idom(to) != from || has_proper_support(to)) {
+        rebuild_subtree(nca);
+        return;
+    }
+    delete_unreachable(to);
+}
+
+bool DominanceUpdater::has_proper_support(BasicBlock *block) const {
+    for (auto *pred : preds(block)) {
+        if (m_info.is_reachable(pred) && m_info.nearest_common_dominator(block, pred) != block) {
+            return true;
         }
     }
     return false;
 }
 
+void DominanceUpdater::delete_unreachable(BasicBlock *block) {
+    // Everything dominated by the block is now unreachable. Successors outside of its subtree lose predecessors, so
+    // find the highest common dominator of those to rebuild from.
+    Vector<BasicBlock *> subtree;
+    HashSet<BasicBlock *> subtree_set;
+    subtree.push(block);
+    subtree_set.insert(block);
+    for (std::uint32_t i = 0; i < subtree.size(); i++) {
+        for (auto *child : m_info.m_nodes.at(subtree[i]).children) {
+            subtree.push(child);
+            subtree_set.insert(child);
+        }
+    }
+
+    auto *rebuild_root = block;
+    for (auto *subtree_block : subtree) {
+        for (auto *succ : succs(subtree_block)) {
+            if (!m_info.is_reachable(succ) || subtree_set.contains(succ)) {
+                continue;
+            }
+            auto *nca = m_info.nearest_common_dominator(succ, block);
+            if (nca != succ && m_info.m_nodes.at(nca).level < m_info.m_nodes.at(rebuild_root).level) {
+                rebuild_root = nca;
+            }
+        }
+    }
+
+    remove(m_info.m_nodes.at(m_info.idom(block)).children, block);
+    for (auto *subtree_block : subtree) {
+        m_info.m_nodes.erase(subtree_block);
+    }
+    if (rebuild_root != block) {
+        rebuild_subtree(rebuild_root);
+    }
+}
+
+void DominanceUpdater::rebuild_subtree(BasicBlock *root) {
+    // Any path from the root to a block in its subtree stays within the subtree, so it can be rebuilt by only visiting
+    // the blocks below the root's level.
+    Vector<BasicBlock *> old_subtree;
+    old_subtree.push(root);
+    for (std::uint32_t i = 0; i < old_subtree.size(); i++) {
+        for (auto *child : m_info.m_nodes.at(old_subtree[i]).children) {
+            old_subtree.push(child);
+        }
+    }
+
+    const auto root_level = m_info.m_nodes.at(root).level;
+    BlockNumbering numbering;
+    auto infos = run_semi_nca(
+        root, numbering,
+        [this](BasicBlock *block) {
+            return succs(block);
+        },
+        [this](BasicBlock *block) {
+            return preds(block);
+        },
+        [&](BasicBlock *block) {
+            return m_info.is_reachable(block) && m_info.m_nodes.at(block).level > root_level;
+        });
+
+    for (auto *block : old_subtree) {
+        m_info.m_nodes.at(block).children.clear();
+    }
+    for (auto [block, idom] : infos) {
+        if (block != root) {
+            auto &node = m_info.m_nodes.at(block);
+            node.idom = infos[idom].first;
+            node.level = m_info.m_nodes.at(node.idom).level + 1;
+            m_info.m_nodes.at(node.idom).children.push(block);
+        }
+    }
+    assert(infos.size() == old_subtree.size());
+}
+
+void DominanceInfo::set_idom(BasicBlock *block, BasicBlock *idom) {
+    auto &node = m_nodes[block];
+    node.idom = idom;
+    node.level = 0;
+    node.index = m_index_count++;
+    if (idom != nullptr) {
+        auto &idom_node = m_nodes.at(idom);
+        node.level = idom_node.level + 1;
+        idom_node.children.push(block);
+    }
+}
+
+void DominanceInfo::apply_updates(Span<const CfgUpdate> updates) {
+    DominanceUpdater(*this, updates).run();
+}
+
+void DominanceInfo::insert_edge(BasicBlock *from, BasicBlock *to) {
+    const CfgUpdate update{CfgUpdateKind::Insert, from, to};
+    apply_updates(codespy::make_span(&update, 1));
+}
+
+void DominanceInfo::delete_edge(BasicBlock *from, BasicBlock *to) {
+    const CfgUpdate update{CfgUpdateKind::Delete, from, to};
+    apply_updates(codespy::make_span(&update, 1));
+}
+
+void DominanceInfo::remove_block(BasicBlock *block) {
+    assert(!is_reachable(block));
+    m_nodes.erase(block);
+}
+
+void DominanceInfo::merge_block(BasicBlock *block) {
+    auto node = std::move(m_nodes.at(block));
+    m_nodes.erase(block);
+    auto &idom_node = m_nodes.at(node.idom);
+    for (std::uint32_t i = 0; i < idom_node.children.size(); i++) {
+        if (idom_node.children[i] == block) {
+            idom_node.children[i] = idom_node.children.last();
+            idom_node.children.pop();
+            break;
+        }
+    }
+
+    // Every block in the subtree moves up a level.
+    Vector<BasicBlock *> worklist;
+    for (auto *child : node.children) {
+        m_nodes.at(child).idom = node.idom;
+        idom_node.children.push(child);
+        worklist.push(child);
+    }
+    while (!worklist.empty()) {
+        auto &child_node = m_nodes.at(worklist.take_last());
+        child_node.level--;
+        for (auto *grandchild : child_node.children) {
+            worklist.push(grandchild);
+        }
+    }
+}
+
+bool DominanceInfo::dominates(BasicBlock *dominator, BasicBlock *block) const {
+    auto block_it = m_nodes.find(block);
+    if (block_it == m_nodes.end()) {
+        // An unreachable block is dominated by everything.
+        return true;
+    }
+    auto dominator_it = m_nodes.find(dominator);
+    if (dominator_it == m_nodes.end()) {
+        return false;
+    }
+
+    // Walk up the tree until we reach the dominator's level.
+    const auto level = dominator_it->second.level;
+    while (block_it->second.level > level) {
+        block_it = m_nodes.find(block_it->second.idom);
+    }
+    return block_it->first == dominator;
+}
+
 bool DominanceInfo::strictly_dominates(BasicBlock *dominator, BasicBlock *block) const {
     return dominator != block && dominates(dominator, block);
 }
@@ -56,88 +649,131 @@ bool DominanceInfo::dominates(Instruction *def, Instruction *user) const {
     codespy::unreachable();
 }
 
-IteratorRange<std::unordered_set<BasicBlock *>::const_iterator> DominanceInfo::frontiers(BasicBlock *block) const {
-    if (!m_frontiers.contains(block)) {
-        return {{}, {}};
-    }
-    const auto &set = m_frontiers.at(block);
-    return codespy::make_range(set.begin(), set.end());
+BasicBlock *DominanceInfo::idom(BasicBlock *block) const {
+    return m_nodes.at(block).idom;
 }
 
-static void dfs(std::unordered_map<BasicBlock *, unsigned> &index_map, Vector<BasicBlock *> &post_order,
-                BasicBlock *block) {
-    index_map[block];
-    for (auto *succ : ir::succs_of(block)) {
-        if (!index_map.contains(succ)) {
-            dfs(index_map, post_order, succ);
+BasicBlock *DominanceInfo::nearest_common_dominator(BasicBlock *lhs, BasicBlock *rhs) const {
+    const auto *lhs_node = &m_nodes.at(lhs);
+    const auto *rhs_node = &m_nodes.at(rhs);
+    while (lhs != rhs) {
+        if (lhs_node->level < rhs_node->level) {
+            std::swap(lhs, rhs);
+            std::swap(lhs_node, rhs_node);
         }
+        lhs = lhs_node->idom;
+        lhs_node = &m_nodes.at(lhs);
     }
-    index_map[block] = post_order.size();
-    post_order.push(block);
+    return lhs;
 }
 
-DominanceInfo compute_dominance(Function *function) {
-    if (function->blocks().empty()) {
-        return {{}, {}};
+// Based on "A Linear Time Algorithm for Placing phi-Nodes" (Sreedhar, Gao). Rather than materialising the frontier of
+// every block, the dominator tree is walked from each definition, deepest first. Any CFG edge that isn't a dominator
+// tree edge (a J-edge in the DJ-graph) leading to a block no deeper than the current root is in the frontier. Each
+// block is visited at most once, making it linear in the size of the CFG.
+Vector<BasicBlock *> DominanceInfo::iterated_frontier(Span<BasicBlock *const> def_blocks) const {
+    const CfgSnapshot cfg(m_function);
+    Vector<std::uint32_t> def_ids;
+    for (auto *block : def_blocks) {
+        if (cfg.contains(block)) {
+            def_ids.push(cfg.id(block));
+        }
     }
+    Vector<BasicBlock *> frontier;
+    for (auto id : IteratedFrontier(cfg, *this).compute(def_ids.span())) {
+        frontier.push(cfg.block(id));
+    }
+    return frontier;
+}
 
-    std::unordered_map<BasicBlock *, unsigned> index_map;
-    Vector<BasicBlock *> order;
-    dfs(index_map, order, function->entry_block());
-
-    std::unordered_map<BasicBlock *, BasicBlock *> idoms;
-    idoms.emplace(function->entry_block(), function->entry_block());
+IteratedFrontier::IteratedFrontier(const CfgSnapshot &cfg, const DominanceInfo &dom_info)
+    : m_cfg(cfg), m_is_def(cfg.block_count()), m_visited_queue(cfg.block_count()),
+      m_visited_worklist(cfg.block_count()) {
+    // Flatten the dominator tree into CSR form by snapshot id. Immediate dominators have lower ids than the blocks they
+    // dominate, so levels can be computed in id order.
+    const auto block_count = cfg.block_count();
+    Vector<std::uint32_t> idoms;
+    idoms.ensure_size(block_count, 0u);
+    m_levels.ensure_size(block_count, 0u);
+    m_child_offsets.ensure_size(block_count + 1, 0u);
+    for (std::uint32_t id = 1; id < block_count; id++) {
+        idoms[id] = cfg.id(dom_info.idom(cfg.block(id)));
+        m_levels[id] = m_levels[idoms[id]] + 1;
+        m_child_offsets[idoms[id] + 1]++;
+    }
+    for (std::uint32_t id = 0; id < block_count; id++) {
+        m_child_offsets[id + 1] += m_child_offsets[id];
+    }
+    Vector<std::uint32_t> insert_positions(m_child_offsets.begin(), m_child_offsets.end() - 1);
+    m_children.ensure_size(block_count - 1, 0u);
+    for (std::uint32_t id = 1; id < block_count; id++) {
+        m_children[insert_positions[idoms[id]]++] = id;
+    }
+}
 
-    auto intersect = [&](BasicBlock *finger1, BasicBlock *finger2) {
-        while (finger1 != finger2) {
-            while (index_map.at(finger1) < index_map.at(finger2)) {
-                finger1 = idoms.at(finger1);
-            }
-            while (index_map.at(finger2) < index_map.at(finger1)) {
-                finger2 = idoms.at(finger2);
-            }
+Vector<std::uint32_t> IteratedFrontier::compute(Span<const std::uint32_t> def_blocks) {
+    // Ordered by (level, id) so that the deepest blocks are processed first, with ties broken deterministically.
+    using QueueEntry = std::pair<std::uint32_t, std::uint32_t>;
+    std::priority_queue<QueueEntry> queue;
+    m_is_def.clear_all();
+    m_visited_queue.clear_all();
+    m_visited_worklist.clear_all();
+    for (auto block : def_blocks) {
+        if (!m_is_def.test_and_set(block)) {
+            queue.emplace(m_levels[block], block);
         }
-        return finger1;
-    };
+    }
 
-    assert(order.last() == function->entry_block());
-    bool changed = false;
-    do {
-        // For all nodes in reverse postorder (excl. entry)
-        for (unsigned i = order.size() - 1; i > 0; i--) {
-            auto *block = order[i - 1];
+    Vector<std::uint32_t> frontier;
+    while (!queue.empty()) {
+        const auto [root_level, root] = queue.top();
+        queue.pop();
 
-            // For all other predecessors of block
-            ir::BasicBlock *new_idom = nullptr;
-            for (auto *pred : ir::preds_of(block)) {
-                if (!idoms.contains(pred)) {
+        m_worklist.push(root);
+        m_visited_worklist.set(root);
+        while (!m_worklist.empty()) {
+            const auto block = m_worklist.take_last();
+            for (auto succ : m_cfg.succs(block)) {
+                if (m_levels[succ] > root_level || m_visited_queue.test_and_set(succ)) {
                     continue;
                 }
-                if (new_idom == nullptr) {
-                    new_idom = pred;
-                } else {
-                    new_idom = intersect(pred, new_idom);
+                frontier.push(succ);
+                if (!m_is_def.test(succ)) {
+                    queue.emplace(m_levels[succ], succ);
                 }
             }
-
-            changed |= std::exchange(idoms[block], new_idom) != new_idom;
-        }
-    } while (std::exchange(changed, false));
-
-    std::unordered_map<BasicBlock *, std::unordered_set<BasicBlock *>> frontiers;
-    for (auto *block : function->blocks()) {
-        if (std::distance(ir::pred_begin(block), ir::pred_end(block)) < 2) {
-            // Not a join point.
-            continue;
-        }
-        for (auto *runner : ir::preds_of(block)) {
-            while (runner != idoms.at(block)) {
-                frontiers[runner].insert(block);
-                runner = idoms.at(runner);
+            for (auto child : children(block)) {
+                if (!m_visited_worklist.test_and_set(child)) {
+                    m_worklist.push(child);
+                }
             }
         }
     }
-    return {std::move(idoms), std::move(frontiers)};
+    return frontier;
+}
+
+DominanceInfo compute_dominance(Function *function, DominanceAlgorithm algorithm) {
+    return compute_dominance(CfgSnapshot(function), algorithm);
+}
+
+DominanceInfo compute_dominance(const CfgSnapshot &cfg, DominanceAlgorithm algorithm) {
+    DominanceInfo info(cfg.function());
+    if (cfg.block_count() == 0) {
+        return info;
+    }
+
+    if (algorithm == DominanceAlgorithm::Auto) {
+        const bool large = cfg.block_count() > k_semi_nca_threshold;
+        algorithm = large ? DominanceAlgorithm::SemiNca : DominanceAlgorithm::Iterative;
+    }
+    auto idoms = algorithm == DominanceAlgorithm::SemiNca ? compute_idoms_semi_nca(cfg) : compute_idoms_iterative(cfg);
+
+    // Blocks are given in an order where each immediate dominator comes before the blocks it dominates.
+    info.m_nodes.ensure_capacity(idoms.size());
+    for (auto [block, idom] : idoms) {
+        info.set_idom(block, idom);
+    }
+    return info;
 }
 
 } // namespace codespy::ir
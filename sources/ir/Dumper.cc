@@ -1,8 +1,9 @@
 #include <codespy/ir/Dumper.hh>
 
+#include <codespy/container/HashMap.hh>
 #include <codespy/container/Vector.hh>
 #include <codespy/ir/BasicBlock.hh>
-#include <codespy/ir/Cfg.hh>
+#include <codespy/ir/CfgSnapshot.hh>
 #include <codespy/ir/Constant.hh>
 #include <codespy/ir/Context.hh>
 #include <codespy/ir/Function.hh>
@@ -14,17 +15,13 @@
 #include <codespy/support/String.hh>
 #include <codespy/support/StringBuilder.hh>
 
-#include <algorithm>
-#include <unordered_map>
-#include <unordered_set>
-
 namespace codespy::ir {
 namespace {
 
 class Dumper final : public Visitor {
     StringBuilder m_sb;
-    std::unordered_map<BasicBlock *, std::size_t> m_block_map;
-    std::unordered_map<Value *, std::size_t> m_value_map;
+    HashMap<BasicBlock *, std::size_t> m_block_map;
+    HashMap<Value *, std::size_t> m_value_map;
 
     String value_string(Value *value);
 
@@ -96,15 +93,6 @@ String Dumper::value_string(Value *value) {
     return codespy::format("{} %v{}", type_string(value->type()), m_value_map.at(value));
 }
 
-void dfs(Vector<BasicBlock *> &post_order, std::unordered_set<BasicBlock *> &visited, BasicBlock *block) {
-    for (auto *succ : ir::succs_of(block)) {
-        if (visited.insert(succ).second) {
-            dfs(post_order, visited, succ);
-        }
-    }
-    post_order.push(block);
-}
-
 void Dumper::run_on(Function *function) {
     m_sb.append("{} @{}(", type_string(function->function_type()->return_type()), function->display_name());
     for (auto *argument : function->arguments()) {
@@ -119,11 +107,9 @@ void Dumper::run_on(Function *function) {
         return;
     }
 
-    // Construct reverse post order.
-    Vector<BasicBlock *> block_order;
-    std::unordered_set<BasicBlock *> visited_blocks;
-    dfs(block_order, visited_blocks, function->entry_block());
-    std::reverse(block_order.begin(), block_order.end());
+    // Blocks are printed in reverse post order.
+    const CfgSnapshot cfg(function);
+    const auto block_order = cfg.blocks();
 
     // Materialise unique value identifiers now.
     for (auto *block : block_order) {
@@ -22,7 +22,7 @@ BasicBlock *Function::append_block() {
 }
 
 Local *Function::append_local(Type *type) {
-    return m_locals.emplace<Local>(m_locals.end(), type, m_locals.size_slow());
+    return m_locals.emplace<Local>(m_locals.end(), type, m_local_count++);
 }
 
 Argument *Function::argument(std::size_t index) {
@@ -39,6 +39,13 @@ void Function::remove_local(Local *local) {
     m_locals.erase(List<Local>::iterator(local));
 }
 
+void Function::remove_locals() {
+    while (!m_locals.empty()) {
+        remove_local(m_locals.first());
+    }
+    m_local_count = 0;
+}
+
 void Function::set_name_prefix(String name_prefix) {
     m_display_name = codespy::format("{}.{}", name_prefix, m_name);
 }
@@ -1,7 +1,9 @@
 #include <codespy/ir/Instruction.hh>
 
 #include <codespy/ir/BasicBlock.hh>
+#include <codespy/ir/Constant.hh>
 #include <codespy/ir/Instructions.hh>
+#include <codespy/ir/Type.hh>
 #include <codespy/ir/Visitor.hh>
 
 namespace codespy::ir {
@@ -28,6 +30,12 @@ void Instruction::accept(Visitor &visitor) {
     }
 }
 
+void Instruction::drop_operands() {
+    for (unsigned i = 0; i < m_operand_count; i++) {
+        m_operands[i].set(nullptr);
+    }
+}
+
 void Instruction::remove_from_parent() {
     m_parent->remove(this);
 }
@@ -56,6 +64,39 @@ unsigned Instruction::successor_count() const {
     return 0;
 }
 
+bool Instruction::may_throw() const {
+    switch (m_opcode) {
+    case Opcode::ArrayLength:
+    case Opcode::Call:
+    case Opcode::LoadArray:
+    case Opcode::LoadField:
+    case Opcode::Monitor:
+    case Opcode::New:
+    case Opcode::NewArray:
+    case Opcode::StoreArray:
+    case Opcode::StoreField:
+    case Opcode::Throw:
+        return true;
+    case Opcode::Binary: {
+        // Integer division by zero.
+        const auto *binary = static_cast<const BinaryInst *>(this);
+        if (binary->op() != BinaryOp::Div && binary->op() != BinaryOp::Rem) {
+            return false;
+        }
+        if (binary->type()->kind() != TypeKind::Integer) {
+            return false;
+        }
+        const auto *divisor = value_cast<ConstantInt>(binary->rhs());
+        return divisor == nullptr || divisor->value() == 0;
+    }
+    case Opcode::Cast:
+        // Only reference casts are checked.
+        return type()->kind() == TypeKind::Reference || type()->kind() == TypeKind::Array;
+    default:
+        return false;
+    }
+}
+
 bool Instruction::is_terminator() const {
     switch (m_opcode) {
 #define TERM_INST(opcode, Class) case Opcode::opcode:
@@ -54,16 +54,6 @@ Function *CallInst::callee() const {
     return static_cast<Function *>(operand(0));
 }
 
-Vector<Value *> CallInst::arguments() const {
-    const auto count = callee()->function_type()->parameter_types().size();
-    Vector<Value *> ret;
-    ret.ensure_capacity(count);
-    for (std::size_t i = 0; i < count; i++) {
-        ret.push(operand(i + 1));
-    }
-    return ret;
-}
-
 CastInst::CastInst(BasicBlock *parent, Type *type, Value *value) : Instruction(k_opcode, parent, type, 1) {
     set_operand(0, value);
 }
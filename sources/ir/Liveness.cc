@@ -0,0 +1,40 @@
+#include <codespy/ir/Liveness.hh>
+
+#include <codespy/ir/BasicBlock.hh>
+#include <codespy/ir/CfgSnapshot.hh>
+#include <codespy/ir/Function.hh>
+#include <codespy/ir/Instructions.hh>
+
+namespace codespy::ir {
+
+LocalLiveness::LocalLiveness(const CfgSnapshot &cfg)
+    : m_data_flow(cfg, cfg.function()->local_count(), DataFlowDirection::Backward, DataFlowMeet::Union) {
+    // A local is generated by a load before any store in the block, and killed by any store.
+    auto &gen = m_data_flow.gen();
+    auto &kill = m_data_flow.kill();
+    for (std::uint32_t id = 0; id < cfg.block_count(); id++) {
+        for (auto *inst : *cfg.block(id)) {
+            if (auto *load = value_cast<LoadInst>(inst)) {
+                auto *local = value_cast<Local>(load->pointer());
+                if (local != nullptr && !kill.test(id, local->index())) {
+                    gen.set(id, local->index());
+                }
+            } else if (auto *store = value_cast<StoreInst>(inst)) {
+                if (auto *local = value_cast<Local>(store->pointer())) {
+                    kill.set(id, local->index());
+                }
+            }
+        }
+    }
+    m_data_flow.solve();
+}
+
+bool LocalLiveness::is_live_in(std::uint32_t block, const Local *local) const {
+    return live_in().test(block, local->index());
+}
+
+bool LocalLiveness::is_live_out(std::uint32_t block, const Local *local) const {
+    return live_out().test(block, local->index());
+}
+
+} // namespace codespy::ir
@@ -0,0 +1,71 @@
+#include <codespy/ir/MutationBatch.hh>
+
+#include <codespy/ir/BasicBlock.hh>
+#include <codespy/ir/Instruction.hh>
+#include <codespy/ir/Value.hh>
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <functional>
+#include <utility>
+
+namespace codespy::ir {
+
+void MutationBatch::replace_all_uses_with(Value *from, Value *to) {
+    to = resolve(to);
+    assert(from != to);
+    [[maybe_unused]] const bool inserted = m_replacement_map.emplace(from, to).second;
+    assert(inserted);
+    m_replacements.push(std::make_pair(from, to));
+}
+
+void MutationBatch::remove(Instruction *inst) {
+    m_removals.push(inst);
+}
+
+void MutationBatch::replace_and_remove(Instruction *inst, Value *value) {
+    replace_all_uses_with(inst, value);
+    remove(inst);
+}
+
+Value *MutationBatch::resolve(Value *value) const {
+    // Targets are resolved when queued, but may have been replaced themselves since.
+    if (m_replacement_map.empty()) {
+        return value;
+    }
+    for (auto it = m_replacement_map.find(value); it != m_replacement_map.end(); it = m_replacement_map.find(value)) {
+        value = it->second;
+    }
+    return value;
+}
+
+void MutationBatch::apply() {
+    // Applying in queue order means that anything replaced with a value which is itself replaced later gets carried
+    // along with it.
+    for (auto [from, to] : m_replacements) {
+        from->replace_all_uses_with(to);
+    }
+    for (auto *inst : m_removals) {
+        inst->drop_operands();
+    }
+
+    // Bring the removals from each block together.
+    std::sort(m_removals.begin(), m_removals.end(), [](Instruction *lhs, Instruction *rhs) {
+        return std::less<BasicBlock *>()(lhs->parent(), rhs->parent());
+    });
+    for (std::uint32_t begin = 0; begin < m_removals.size();) {
+        auto *block = m_removals[begin]->parent();
+        std::uint32_t end = begin + 1;
+        while (end < m_removals.size() && m_removals[end]->parent() == block) {
+            end++;
+        }
+        block->remove(m_removals.span().subspan(begin, end - begin));
+        begin = end;
+    }
+    m_replacements.clear();
+    m_replacement_map.clear();
+    m_removals.clear();
+}
+
+} // namespace codespy::ir
@@ -0,0 +1,67 @@
+#include <codespy/ir/ReachingDefinitions.hh>
+
+#include <codespy/ir/BasicBlock.hh>
+#include <codespy/ir/CfgSnapshot.hh>
+#include <codespy/ir/Function.hh>
+#include <codespy/ir/Instructions.hh>
+
+namespace codespy::ir {
+namespace {
+
+Vector<StoreInst *> collect_stores(const CfgSnapshot &cfg) {
+    Vector<StoreInst *> stores;
+    for (auto *block : cfg.blocks()) {
+        for (auto *inst : *block) {
+            if (auto *store = value_cast<StoreInst>(inst); store != nullptr && value_is<Local>(store->pointer())) {
+                stores.push(store);
+            }
+        }
+    }
+    return stores;
+}
+
+} // namespace
+
+ReachingDefinitions::ReachingDefinitions(const CfgSnapshot &cfg)
+    : m_stores(collect_stores(cfg)),
+      m_data_flow(cfg, m_stores.size(), DataFlowDirection::Forward, DataFlowMeet::Union) {
+    // Group the stores by local so that a store can kill every other store to the same local.
+    auto *function = cfg.function();
+    Vector<Vector<std::uint32_t>> stores_by_local(function->local_count());
+    for (std::uint32_t i = 0; i < m_stores.size(); i++) {
+        stores_by_local[static_cast<Local *>(m_stores[i]->pointer())->index()].push(i);
+    }
+
+    // Stores were collected in block order, so each block's stores form a contiguous run. The last store to each local
+    // in a block is generated, and every store to a local stored to in the block is killed.
+    constexpr auto k_no_store = ~0u;
+    Vector<std::uint32_t> last_store;
+    last_store.ensure_size(function->local_count(), k_no_store);
+    Vector<std::uint32_t> stored_locals;
+    auto &gen = m_data_flow.gen();
+    auto &kill = m_data_flow.kill();
+    std::uint32_t store_index = 0;
+    for (std::uint32_t id = 0; id < cfg.block_count(); id++) {
+        for (auto *inst : *cfg.block(id)) {
+            if (store_index == m_stores.size() || inst != m_stores[store_index]) {
+                continue;
+            }
+            const auto local = static_cast<Local *>(m_stores[store_index]->pointer())->index();
+            if (last_store[local] == k_no_store) {
+                stored_locals.push(local);
+            }
+            last_store[local] = store_index++;
+        }
+        while (!stored_locals.empty()) {
+            const auto local = stored_locals.take_last();
+            for (auto store : stores_by_local[local]) {
+                kill.set(id, store);
+            }
+            gen.set(id, last_store[local]);
+            last_store[local] = k_no_store;
+        }
+    }
+    m_data_flow.solve();
+}
+
+} // namespace codespy::ir
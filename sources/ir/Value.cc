@@ -25,13 +25,16 @@ void Use::remove_from_list() {
     if (m_next != nullptr) {
         m_next->m_prev = m_prev;
     }
+    m_prev = nullptr;
+    m_next = nullptr;
 }
 
 void Use::set(Value *value) {
-    if (std::exchange(m_value, value) != nullptr) {
+    if (is_linked()) {
         remove_from_list();
     }
-    if (value != nullptr) {
+    m_value = value;
+    if (value != nullptr && value->tracks_uses()) {
         value->add_use(*this);
     }
 }
@@ -92,9 +95,29 @@ void Value::destroy() {
 }
 
 void Value::replace_all_uses_with(Value *value) {
-    while (m_use_list != nullptr) {
-        m_use_list->set(value);
+    if (value == nullptr || !value->tracks_uses()) {
+        while (m_use_list != nullptr) {
+            m_use_list->set(value);
+        }
+        return;
+    }
+    if (value == this || m_use_list == nullptr) {
+        return;
+    }
+
+    // Retarget every use, then splice the whole list onto the front of the new value's list at once rather than
+    // unlinking and relinking each use.
+    Use *last = m_use_list;
+    for (auto *use = m_use_list; use != nullptr; use = use->m_next) {
+        use->m_value = value;
+        last = use;
+    }
+    last->m_next = value->m_use_list;
+    if (last->m_next != nullptr) {
+        last->m_next->m_prev = &last->m_next;
     }
+    value->m_use_list = std::exchange(m_use_list, nullptr);
+    value->m_use_list->m_prev = &value->m_use_list;
 }
 
 } // namespace codespy::ir
@@ -15,11 +15,11 @@
 #include <codespy/support/Print.hh>
 #include <codespy/support/SpanStream.hh>
 #include <codespy/support/StringBuilder.hh>
-#include <codespy/transform/CfgSimplifier.hh>
-#include <codespy/transform/ExceptionPruner.hh>
-#include <codespy/transform/LocalPromoter.hh>
+#include <codespy/transform/PassManager.hh>
 
 #include <QApplication>
+#include <chrono>
+#include <cstdint>
 #include <fstream>
 #include <iostream>
 #include <miniz/miniz.h>
@@ -28,13 +28,44 @@
 using namespace codespy;
 
 int main(int argc, char **argv) {
+    // By default, run the cheap pipeline up front and upgrade classes to the full pipeline when they're opened.
+    const char *jar_path = nullptr;
+    StringView pipeline = ir::pipeline_spec(ir::OptLevel::O1);
+    bool tiered = true;
+    bool time_passes = false;
+    bool print_stats = false;
+    for (int i = 1; i < argc; i++) {
+        const StringView arg(argv[i]);
+        if (arg == "-O0" || arg == "-O1" || arg == "-O2") {
+            pipeline = ir::pipeline_spec(static_cast<ir::OptLevel>(arg[2] - '0'));
+            tiered = false;
+        } else if (arg.length() >= 9 && arg.substr(0, 9) == "--passes=") {
+            pipeline = arg.substr(9);
+            tiered = false;
+        } else if (arg == "--time-passes") {
+            time_passes = true;
+        } else if (arg == "--stats") {
+            print_stats = true;
+        } else {
+            jar_path = argv[i];
+        }
+    }
+
+    ir::PassManager pass_manager;
+    if (ir::parse_pipeline(pipeline, pass_manager).is_error()) {
+        println("Invalid pipeline '{}'", pipeline);
+        return 1;
+    }
+    ir::PassManager upgrade_pass_manager;
+    CODESPY_EXPECT(ir::parse_pipeline(ir::pipeline_spec(ir::OptLevel::O2), upgrade_pass_manager));
+
     ir::Context context;
     bc::Frontend frontend(context);
 
     std::unordered_map<String, String> bc_text_map;
 
     mz_zip_archive zip_archive{};
-    mz_zip_reader_init_file(&zip_archive, argv[1], 0);
+    mz_zip_reader_init_file(&zip_archive, jar_path, 0);
     const auto zip_entry_count = mz_zip_reader_get_num_files(&zip_archive);
     for (mz_uint i = 0; i < zip_entry_count; i++) {
         Array<char, 256> name_chars{};
@@ -65,11 +96,29 @@ int main(int argc, char **argv) {
             continue;
         }
         StringBuilder sb;
+        Vector<ir::Function *> pending_methods;
         for (auto *function : clazz.methods()) {
-            ir::prune_exceptions(function);
-            ir::simplify_cfg(function);
-            ir::promote_locals(function);
-            ir::simplify_cfg(function);
+            if (tiered) {
+                pending_methods.push(function);
+            }
+            const auto records = pass_manager.run(function);
+            if (time_passes || print_stats) {
+                StringBuilder record_sb;
+                record_sb.append("{}:", function->display_name());
+                for (const auto &record : records) {
+                    record_sb.append(" {}", record.pass_name);
+                    if (time_passes) {
+                        const auto micros = std::chrono::duration_cast<std::chrono::microseconds>(record.duration);
+                        record_sb.append(" {}us", static_cast<std::int64_t>(micros.count()));
+                    }
+                    if (print_stats) {
+                        for (const auto &statistic : record.statistics) {
+                            record_sb.append(" {}={}", statistic.name, statistic.value);
+                        }
+                    }
+                }
+                println(record_sb.build());
+            }
             sb.append(ir::dump_code(function));
             sb.append('\n');
         }
@@ -80,11 +129,12 @@ int main(int argc, char **argv) {
             .name = QString::fromUtf8(name.data(), name.length()),
             .ir_text = QString::fromUtf8(ir_text.data(), ir_text.length()),
             .bc_text = QString::fromUtf8(bc_text.data(), bc_text.length()),
+            .pending_methods = std::move(pending_methods),
         });
     }
 
     QApplication application(argc, argv);
-    gui::MainWindow window(std::move(classes));
+    gui::MainWindow window(std::move(classes), tiered ? &upgrade_pass_manager : nullptr);
     window.show();
     return QApplication::exec();
 }
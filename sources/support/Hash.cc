@@ -0,0 +1,68 @@
+#include <codespy/support/Hash.hh>
+
+#include <cstring>
+
+namespace codespy {
+namespace {
+
+constexpr std::uint64_t k_secret0 = 0x2d358dccaa6c78a5u;
+constexpr std::uint64_t k_secret1 = 0x8bb84b93962eacc9u;
+constexpr std::uint64_t k_secret2 = 0x4b33a62ed433d4a3u;
+constexpr std::uint64_t k_secret3 = 0x4d5a2da51de1aa47u;
+
+std::uint64_t read64(const std::uint8_t *bytes) {
+    std::uint64_t value;
+    std::memcpy(&value, bytes, sizeof(value));
+    return value;
+}
+
+std::uint64_t read32(const std::uint8_t *bytes) {
+    std::uint32_t value;
+    std::memcpy(&value, bytes, sizeof(value));
+    return value;
+}
+
+} // namespace
+
+std::size_t hash_bytes(const void *data, std::size_t length) {
+    const auto *bytes = static_cast<const std::uint8_t *>(data);
+    std::uint64_t seed = hash_mix(k_secret0, k_secret1);
+    std::uint64_t a = 0;
+    std::uint64_t b = 0;
+    if (length <= 16) {
+        // Short strings, which are by far the most common, are read with (possibly overlapping) loads from either end.
+        if (length >= 4) {
+            const auto middle = (length >> 3u) << 2u;
+            a = (read32(bytes) << 32u) | read32(bytes + middle);
+            b = (read32(bytes + length - 4) << 32u) | read32(bytes + length - 4 - middle);
+        } else if (length > 0) {
+            a = (std::uint64_t(bytes[0]) << 16u) | (std::uint64_t(bytes[length >> 1u]) << 8u) | bytes[length - 1];
+        }
+    } else {
+        std::size_t remaining = length;
+        if (remaining > 48) {
+            // Three independent lanes, so that the multiplies can overlap.
+            std::uint64_t seed1 = seed;
+            std::uint64_t seed2 = seed;
+            do {
+                seed = hash_mix(read64(bytes) ^ k_secret1, read64(bytes + 8) ^ seed);
+                seed1 = hash_mix(read64(bytes + 16) ^ k_secret2, read64(bytes + 24) ^ seed1);
+                seed2 = hash_mix(read64(bytes + 32) ^ k_secret3, read64(bytes + 40) ^ seed2);
+                bytes += 48;
+                remaining -= 48;
+            } while (remaining > 48);
+            seed ^= seed1 ^ seed2;
+        }
+        while (remaining > 16) {
+            seed = hash_mix(read64(bytes) ^ k_secret1, read64(bytes + 8) ^ seed);
+            bytes += 16;
+            remaining -= 16;
+        }
+        // The last 16 bytes, overlapping with what's already been hashed if needed.
+        a = read64(bytes + remaining - 16);
+        b = read64(bytes + remaining - 8);
+    }
+    return hash_mix(hash_mix(a ^ k_secret1, b ^ seed) ^ k_secret0 ^ length, seed ^ k_secret1);
+}
+
+} // namespace codespy
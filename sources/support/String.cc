@@ -4,40 +4,64 @@
 #include <codespy/support/Utility.hh>
 
 #include <cassert>
+#include <cstdint>
 #include <cstring>
+#include <utility>
 
 namespace codespy {
 
 String String::copy_raw(const char *data, std::size_t length) {
     String string(length);
-    std::memcpy(string.m_data, data, length);
+    std::memcpy(string.data(), data, length);
     return string;
 }
 
 String String::move_raw(char *data, std::size_t length) {
     assert(data[length] == '\0');
     String string;
-    string.m_data = data;
-    string.m_length = length;
+    string.m_storage.heap = {k_heap_tag, data, length};
     return string;
 }
 
-String::String(std::size_t length) : m_length(length) {
-    m_data = new char[length + 1];
-    m_data[length] = '\0';
+String::String(std::size_t length) {
+    if (length > k_inline_capacity) {
+        m_storage.heap = {k_heap_tag, new char[length + 1], length};
+    } else {
+        m_storage.small.tag = static_cast<std::uint8_t>(length);
+    }
+    raw_data()[length] = '\0';
 }
 
 String::~String() {
-    delete[] m_data;
+    if (!is_inline()) {
+        delete[] m_storage.heap.data;
+    }
 }
 
 String &String::operator=(String &&other) {
-    String moved(std::move(other));
-    std::swap(m_data, moved.m_data);
-    std::swap(m_length, moved.m_length);
+    if (this != &other) {
+        if (!is_inline()) {
+            delete[] m_storage.heap.data;
+        }
+        move_from(other);
+    }
     return *this;
 }
 
+void String::move_from(String &other) {
+    m_storage = std::exchange(other.m_storage, Storage{});
+}
+
+char *String::disown() {
+    char *data = raw_data();
+    if (is_inline()) {
+        data = new char[length() + 1];
+        std::memcpy(data, m_storage.small.chars, length() + 1);
+    }
+    m_storage = Storage{};
+    return data;
+}
+
 bool String::ends_with(StringView end) {
     if (end.empty()) {
         return true;
@@ -45,18 +69,18 @@ bool String::ends_with(StringView end) {
     if (empty()) {
         return false;
     }
-    if (end.length() > m_length) {
+    if (end.length() > length()) {
         return false;
     }
-    return memcmp(&m_data[m_length - end.length()], end.data(), end.length()) == 0;
+    return memcmp(raw_data() + length() - end.length(), end.data(), end.length()) == 0;
 }
 
 bool String::operator==(const String &other) const {
-    return StringView(m_data, m_length) == StringView(other.m_data, other.m_length);
+    return view() == other.view();
 }
 
 bool String::operator==(StringView other) const {
-    return StringView(m_data, m_length) == other;
+    return view() == other;
 }
 
 } // namespace codespy
@@ -2,54 +2,194 @@
 
 #include <codespy/container/Array.hh>
 #include <codespy/container/Vector.hh>
+#include <codespy/support/FloatDecimal.hh>
 #include <codespy/support/Span.hh>
 #include <codespy/support/String.hh>
 #include <codespy/support/StringView.hh>
 #include <codespy/support/Utility.hh>
 
-#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstddef>
 #include <cstdint>
-#include <cstdio>
+#include <cstring>
 
 namespace codespy {
+namespace {
+
+constexpr auto k_decimal_pairs = [] {
+    Array<char, 200> pairs{};
+    for (std::size_t i = 0; i < 100; i++) {
+        pairs[i * 2] = static_cast<char>('0' + i / 10);
+        pairs[i * 2 + 1] = static_cast<char>('0' + i % 10);
+    }
+    return pairs;
+}();
+
+constexpr auto k_hex_pairs = [] {
+    Array<char, 512> pairs{};
+    for (std::size_t i = 0; i < 256; i++) {
+        pairs[i * 2] = "0123456789abcdef"[i / 16];
+        pairs[i * 2 + 1] = "0123456789abcdef"[i % 16];
+    }
+    return pairs;
+}();
+
+constexpr auto k_powers_of_ten = [] {
+    Array<std::uint64_t, 20> powers{};
+    powers[0] = 1;
+    for (std::size_t i = 1; i < powers.size(); i++) {
+        powers[i] = powers[i - 1] * 10;
+    }
+    return powers;
+}();
+
+std::size_t count_decimal_digits(std::uint64_t value) {
+    // floor(log10(value)) estimated from the bit width, which is either exact or one too large.
+    const auto estimate = (static_cast<std::size_t>(std::bit_width(value | 1u)) * 1233) >> 12u;
+    return estimate + ((value | 1u) < k_powers_of_ten[estimate] ? 0 : 1);
+}
+
+std::size_t count_hex_digits(std::uint64_t value) {
+    return (static_cast<std::size_t>(std::bit_width(value | 1u)) + 3) / 4;
+}
+
+// Writes the digits of value backwards from end, two at a time.
+void write_decimal(char *end, std::uint64_t value) {
+    while (value >= 100) {
+        end -= 2;
+        std::memcpy(end, &k_decimal_pairs[value % 100 * 2], 2);
+        value /= 100;
+    }
+    if (value >= 10) {
+        std::memcpy(end - 2, &k_decimal_pairs[value * 2], 2);
+    } else {
+        end[-1] = static_cast<char>('0' + value);
+    }
+}
+
+void write_hex(char *end, std::uint64_t value) {
+    while (value >= 0x100) {
+        end -= 2;
+        std::memcpy(end, &k_hex_pairs[value % 0x100 * 2], 2);
+        value /= 0x100;
+    }
+    if (value >= 0x10) {
+        std::memcpy(end - 2, &k_hex_pairs[value * 2], 2);
+    } else {
+        end[-1] = k_hex_pairs[value * 2 + 1];
+    }
+}
+
+char *write_string(char *out, StringView string) {
+    std::memcpy(out, string.data(), string.length());
+    return out + string.length();
+}
+
+// Writes the shortest representation that converts back to the same value, in the same style as Java's
+// Double.toString, i.e. plain for magnitudes in [10^-3, 10^7) and in scientific notation otherwise. At most 32 chars
+// are written.
+template <typename T>
+char *write_float(char *out, T value) {
+    if (std::isnan(value)) {
+        return write_string(out, "NaN");
+    }
+    if (std::signbit(value)) {
+        *out++ = '-';
+    }
+    if (std::isinf(value)) {
+        return write_string(out, "Infinity");
+    }
+    if (value == 0) {
+        return write_string(out, "0.0");
+    }
+
+    const auto decimal = to_shortest_decimal(value);
+    Array<char, 20> digits{};
+    const auto digit_count = count_decimal_digits(decimal.significand);
+    write_decimal(digits.data() + digit_count, decimal.significand);
+    const auto digit_view = StringView(digits.data(), digit_count);
+
+    // The value is 0.digits * 10^point.
+    const auto point = static_cast<std::int32_t>(digit_count) + decimal.exponent;
+    if (point >= -2 && point <= 7) {
+        if (point <= 0) {
+            out = write_string(out, "0.");
+            out = write_string(out, StringView("000", static_cast<std::size_t>(-point)));
+            return write_string(out, digit_view);
+        }
+        const auto integer_count = static_cast<std::size_t>(point);
+        if (integer_count < digit_count) {
+            out = write_string(out, digit_view.substr(0, integer_count));
+            *out++ = '.';
+            return write_string(out, digit_view.substr(integer_count));
+        }
+        out = write_string(out, digit_view);
+        out = write_string(out, StringView("0000000", integer_count - digit_count));
+        return write_string(out, ".0");
+    }
+
+    *out++ = digits[0];
+    *out++ = '.';
+    out = digit_count > 1 ? write_string(out, digit_view.substr(1)) : write_string(out, "0");
+    *out++ = 'E';
+    auto exponent = point - 1;
+    if (exponent < 0) {
+        *out++ = '-';
+        exponent = -exponent;
+    }
+    const auto exponent_count = count_decimal_digits(static_cast<std::uint64_t>(exponent));
+    write_decimal(out + exponent_count, static_cast<std::uint64_t>(exponent));
+    return out + exponent_count;
+}
+
+} // namespace
+
+char *StringBuilder::grow(std::size_t by) {
+    const auto length = m_buffer.size();
+    m_buffer.ensure_size(length + by);
+    return m_buffer.data() + length;
+}
 
 void StringBuilder::append_single(double arg, const char *) {
-    // TODO: Own implementation.
-    Array<char, 20> buf{};
-    int length = snprintf(buf.data(), buf.size(), "%f", arg); // NOLINT
-    m_buffer.extend(StringView(buf.data(), std::min(buf.size(), static_cast<std::size_t>(length))));
+    Array<char, 32> buf{};
+    const auto *end = write_float(buf.data(), arg);
+    m_buffer.extend(StringView(buf.data(), static_cast<std::size_t>(end - buf.data())));
+}
+
+void StringBuilder::append_single(float arg, const char *) {
+    Array<char, 32> buf{};
+    const auto *end = write_float(buf.data(), arg);
+    m_buffer.extend(StringView(buf.data(), static_cast<std::size_t>(end - buf.data())));
 }
 
 void StringBuilder::append_single(std::int64_t arg, const char *opts) {
     if (arg < 0) {
-        arg = -arg;
+        // Negate as unsigned, since -arg overflows for the minimum value.
         m_buffer.push('-');
+        append_single(0 - static_cast<std::uint64_t>(arg), opts);
+        return;
     }
     append_single(static_cast<std::uint64_t>(arg), opts);
 }
 
 void StringBuilder::append_single(std::uint64_t arg, const char *opts) {
-    const size_t base = opts[0] == 'h' ? 16 : 10;
-    Array<char, 30> buf{};
-    std::uint8_t len = 0;
-    do {
-        auto digit = static_cast<char>(arg % base);
-        buf[len++] = digit < 10 ? '0' + digit : 'a' + digit - 10; // NOLINT
-        arg /= base;
-    } while (arg > 0);
-
-    if (const char pad = opts[1]; pad != '\0') {
-        const char pad_char = opts[2] != '\0' ? opts[2] : '0';
-        for (std::uint8_t i = len; i < pad - '0'; i++) {
-            buf[len++] = pad_char;
-        }
-    }
-    if (opts[0] == 'h') {
-        buf[len++] = 'x';
-        buf[len++] = '0';
+    // The options are h for hex with a 0x prefix, then the width to pad the digits to, then the pad char.
+    const bool hex = opts[0] == 'h';
+    const auto digit_count = hex ? count_hex_digits(arg) : count_decimal_digits(arg);
+    const auto width = opts[1] != '\0' ? static_cast<std::size_t>(opts[1] - '0') : 0;
+    const auto pad_count = width > digit_count ? width - digit_count : 0;
+    char *out = grow((hex ? 2 : 0) + pad_count + digit_count);
+    if (hex) {
+        *out++ = '0';
+        *out++ = 'x';
     }
-    for (std::uint8_t i = len; i > 0; i--) {
-        m_buffer.push(buf[i - 1]);
+    std::memset(out, opts[2] != '\0' ? opts[2] : '0', pad_count);
+    out += pad_count;
+    if (hex) {
+        write_hex(out + digit_count, arg);
+    } else {
+        write_decimal(out + digit_count, arg);
     }
 }
 
@@ -57,6 +197,10 @@ void StringBuilder::append_single(StringView arg, const char *) {
     m_buffer.extend(arg);
 }
 
+void StringBuilder::append(StringView string) {
+    m_buffer.extend(string);
+}
+
 void StringBuilder::append(char ch) {
     m_buffer.push(ch);
 }
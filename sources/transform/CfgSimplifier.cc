@@ -1,48 +1,425 @@
-#include <codespy/transform/ExceptionPruner.hh>
+#include <codespy/transform/CfgSimplifier.hh>
 
+#include <codespy/container/HashSet.hh>
+#include <codespy/container/Vector.hh>
 #include <codespy/ir/BasicBlock.hh>
 #include <codespy/ir/Cfg.hh>
+#include <codespy/ir/Constant.hh>
 #include <codespy/ir/Context.hh>
 #include <codespy/ir/Dominance.hh>
 #include <codespy/ir/Function.hh>
 #include <codespy/ir/Instructions.hh>
-#include <codespy/support/Print.hh>
+#include <codespy/support/Optional.hh>
+
+#include <algorithm>
 
 namespace codespy::ir {
+namespace {
+
+unsigned edge_count(BasicBlock *from, BasicBlock *to) {
+    const auto succs = ir::succs_of(from);
+    return static_cast<unsigned>(std::count(succs.begin(), succs.end(), to));
+}
+
+Vector<BasicBlock *> unique_succs(BasicBlock *block) {
+    Vector<BasicBlock *> succs;
+    for (auto *succ : ir::succs_of(block)) {
+        if (std::find(succs.begin(), succs.end(), succ) == succs.end()) {
+            succs.push(succ);
+        }
+    }
+    return succs;
+}
+
+Vector<BasicBlock *> unique_preds(BasicBlock *block) {
+    Vector<BasicBlock *> preds;
+    for (auto *pred : ir::preds_of(block)) {
+        if (std::find(preds.begin(), preds.end(), pred) == preds.end()) {
+            preds.push(pred);
+        }
+    }
+    return preds;
+}
+
+bool has_phis(BasicBlock *block) {
+    return !block->insts().empty() && ir::value_is<PhiInst>(block->insts().first());
+}
+
+// Rebuilds the PHIs in block so that they have edge_count incoming entries from pred, which must not be more than they
+// currently have.
+void set_phi_edge_count(BasicBlock *block, BasicBlock *pred, unsigned edge_count) {
+    for (auto *inst : codespy::adapt_mutable_range(*block)) {
+        auto *phi = ir::value_cast<PhiInst>(inst);
+        if (phi == nullptr) {
+            // PHIs are contiguous at the top of a block.
+            break;
+        }
 
-static bool do_pass(Function *function) {
-    bool changed = false;
-    for (auto *block : codespy::adapt_mutable_range(function->blocks())) {
-        // Don't touch the entry block.
-        if (block == function->entry_block()) {
+        Value *pred_value = nullptr;
+        unsigned count = 0;
+        for (unsigned i = 0; i < phi->incoming_count(); i++) {
+            if (phi->incoming_block(i) == pred) {
+                pred_value = phi->incoming_value(i);
+                count++;
+            }
+        }
+        if (count == edge_count) {
             continue;
         }
 
-        // Check if trivially dead.
-        if (!block->has_uses()) {
-            changed |= true;
-            block->remove_from_parent();
+        assert(count > edge_count);
+        auto *new_phi = block->insert<PhiInst>(phi, phi->incoming_count() - count + edge_count);
+        unsigned index = 0;
+        for (unsigned i = 0; i < phi->incoming_count(); i++) {
+            if (phi->incoming_block(i) != pred) {
+                new_phi->set_incoming(index++, phi->incoming_block(i), phi->incoming_value(i));
+            }
+        }
+        for (unsigned i = 0; i < edge_count; i++) {
+            new_phi->set_incoming(index++, pred, pred_value);
+        }
+        phi->replace_all_uses_with(new_phi);
+        phi->remove_from_parent();
+    }
+}
+
+Optional<bool> evaluate_condition(Value *condition) {
+    if (auto *constant = ir::value_cast<ConstantInt>(condition)) {
+        return constant->value() != 0;
+    }
+    auto *compare = ir::value_cast<CompareInst>(condition);
+    if (compare == nullptr) {
+        return {};
+    }
+    auto *lhs = ir::value_cast<ConstantInt>(compare->lhs());
+    auto *rhs = ir::value_cast<ConstantInt>(compare->rhs());
+    if (lhs == nullptr || rhs == nullptr) {
+        return {};
+    }
+    switch (compare->op()) {
+    case CompareOp::Equal:
+        return lhs->value() == rhs->value();
+    case CompareOp::NotEqual:
+        return lhs->value() != rhs->value();
+    case CompareOp::LessThan:
+        return lhs->value() < rhs->value();
+    case CompareOp::GreaterThan:
+        return lhs->value() > rhs->value();
+    case CompareOp::LessEqual:
+        return lhs->value() <= rhs->value();
+    case CompareOp::GreaterEqual:
+        return lhs->value() >= rhs->value();
+    }
+    codespy::unreachable();
+}
+
+class CfgSimplifier {
+    Function *m_function;
+    DominanceInfo *m_dom_info;
+    Vector<BasicBlock *> m_worklist;
+    HashSet<BasicBlock *> m_queued;
+
+    void enqueue(BasicBlock *block);
+    void erase_block(BasicBlock *block);
+    bool remove_unreachable_blocks();
+    void remove_dead_block(BasicBlock *block);
+    void fold_terminator(BasicBlock *block);
+    bool forward_block(BasicBlock *block);
+    bool merge_successor(BasicBlock *block);
+    void simplify_block(BasicBlock *block);
+
+public:
+    CfgSimplifier(Function *function, DominanceInfo *dom_info) : m_function(function), m_dom_info(dom_info) {}
+
+    void run();
+};
+
+void CfgSimplifier::enqueue(BasicBlock *block) {
+    if (m_queued.insert(block)) {
+        m_worklist.push(block);
+    }
+}
+
+void CfgSimplifier::erase_block(BasicBlock *block) {
+    // Any stale pointer left in the worklist is skipped since it's no longer in the queued set.
+    m_queued.erase(block);
+    if (m_dom_info != nullptr) {
+        m_dom_info->remove_block(block);
+    }
+    block->remove_from_parent();
+}
+
+bool CfgSimplifier::remove_unreachable_blocks() {
+    HashSet<BasicBlock *> reachable;
+    Vector<BasicBlock *> stack;
+    reachable.insert(m_function->entry_block());
+    stack.push(m_function->entry_block());
+    while (!stack.empty()) {
+        for (auto *succ : ir::succs_of(stack.take_last())) {
+            if (reachable.insert(succ)) {
+                stack.push(succ);
+            }
+        }
+    }
+
+    Vector<BasicBlock *> dead_blocks;
+    for (auto *block : m_function->blocks()) {
+        if (!reachable.contains(block)) {
+            dead_blocks.push(block);
+        }
+    }
+    if (dead_blocks.empty()) {
+        return false;
+    }
+
+    // Detach the dead blocks from the live part of the CFG, then drop their instructions so that any references
+    // between dead blocks (e.g. in an unreachable loop) go away.
+    for (auto *block : dead_blocks) {
+        for (auto *succ : unique_succs(block)) {
+            if (reachable.contains(succ)) {
+                set_phi_edge_count(succ, block, 0);
+                enqueue(succ);
+            }
+        }
+    }
+    for (auto *block : dead_blocks) {
+        for (auto *inst : codespy::adapt_mutable_range(*block)) {
+            inst->remove_from_parent();
+        }
+        for (auto *handler : codespy::adapt_mutable_range(block->handlers())) {
+            handler->remove_from_parent();
+        }
+    }
+    for (auto *block : dead_blocks) {
+        erase_block(block);
+    }
+    return true;
+}
+
+void CfgSimplifier::remove_dead_block(BasicBlock *block) {
+    for (auto *succ : unique_succs(block)) {
+        set_phi_edge_count(succ, block, 0);
+        enqueue(succ);
+    }
+
+    // Any remaining uses must be in other dead blocks which haven't been removed yet.
+    for (auto *inst : *block) {
+        if (inst->has_uses()) {
+            inst->replace_all_uses_with(m_function->context().poison_value(inst->type()));
+        }
+    }
+    erase_block(block);
+}
+
+void CfgSimplifier::fold_terminator(BasicBlock *block) {
+    auto *terminator = block->terminator();
+    BasicBlock *target = nullptr;
+    if (auto *branch = ir::value_cast<BranchInst>(terminator); branch != nullptr && branch->is_conditional()) {
+        if (branch->true_target() == branch->false_target()) {
+            target = branch->true_target();
+        } else if (auto condition = evaluate_condition(branch->condition())) {
+            target = *condition ? branch->true_target() : branch->false_target();
+        }
+    } else if (auto *switch_inst = ir::value_cast<SwitchInst>(terminator)) {
+        if (auto *constant = ir::value_cast<ConstantInt>(switch_inst->value())) {
+            target = switch_inst->default_target();
+            for (unsigned i = 0; i < switch_inst->case_count(); i++) {
+                if (ir::value_cast<ConstantInt>(switch_inst->case_value(i))->value() == constant->value()) {
+                    target = switch_inst->case_target(i);
+                    break;
+                }
+            }
+        } else {
+            bool all_default = true;
+            for (unsigned i = 0; i < switch_inst->case_count(); i++) {
+                all_default &= switch_inst->case_target(i) == switch_inst->default_target();
+            }
+            if (all_default) {
+                target = switch_inst->default_target();
+            } else if (switch_inst->case_count() == 1) {
+                // The edges stay the same, so nothing else needs updating.
+                auto *compare = block->insert<CompareInst>(terminator, CompareOp::Equal, switch_inst->value(),
+                                                           switch_inst->case_value(0));
+                block->insert<BranchInst>(terminator, switch_inst->case_target(0), switch_inst->default_target(),
+                                          compare);
+                terminator->remove_from_parent();
+                return;
+            }
+        }
+    }
+    if (target == nullptr) {
+        return;
+    }
+
+    auto old_succs = unique_succs(block);
+    Vector<unsigned> old_edge_counts;
+    for (auto *succ : old_succs) {
+        old_edge_counts.push(edge_count(block, succ));
+    }
+    block->insert<BranchInst>(terminator, target);
+    terminator->remove_from_parent();
+
+    Vector<CfgUpdate> updates;
+    for (std::uint32_t i = 0; i < old_succs.size(); i++) {
+        auto *succ = old_succs[i];
+        const auto new_edge_count = edge_count(block, succ);
+        if (new_edge_count == old_edge_counts[i]) {
+            continue;
+        }
+        set_phi_edge_count(succ, block, new_edge_count);
+        if (new_edge_count == 0) {
+            updates.push({CfgUpdateKind::Delete, block, succ});
+        }
+        enqueue(succ);
+    }
+    if (m_dom_info != nullptr) {
+        m_dom_info->apply_updates(updates.span());
+    }
+}
+
+bool CfgSimplifier::forward_block(BasicBlock *block) {
+    // Check if the block contains a single unconditional branch instruction. Such a block can't throw, so any handlers
+    // covering it are dropped by prune-exceptions, which the pipelines run first.
+    if (block == m_function->entry_block() || ++block->insts().begin() != block->insts().end() ||
+        !block->handlers().empty()) {
+        return false;
+    }
+    auto *branch = ir::value_cast<BranchInst>(block->terminator());
+    if (branch == nullptr || branch->is_conditional() || branch->target() == block) {
+        return false;
+    }
+
+    // If the target has PHIs, their entries for the block need to be duplicated for each predecessor, which only
+    // works if the predecessors don't already have their own entries.
+    auto *target = branch->target();
+    const auto preds = unique_preds(block);
+    Vector<CfgUpdate> updates;
+    for (auto *pred : preds) {
+        if (edge_count(pred, target) != 0) {
+            if (has_phis(target)) {
+                return false;
+            }
             continue;
         }
+        updates.push({CfgUpdateKind::Insert, pred, target});
+    }
+    for (auto *pred : preds) {
+        updates.push({CfgUpdateKind::Delete, pred, block});
+    }
 
-        // Check if the block contains a single unconditional branch instruction.
-        if (++block->insts().begin() == block->insts().end()) {
-            if (auto *branch = ir::value_cast<ir::BranchInst>(block->terminator())) {
-                changed |= true;
-                block->replace_all_uses_with(branch->target());
-                block->remove_from_parent();
+    const auto pred_edge_count = static_cast<unsigned>(std::distance(ir::pred_begin(block), ir::pred_end(block)));
+    for (auto *inst : codespy::adapt_mutable_range(*target)) {
+        auto *phi = ir::value_cast<PhiInst>(inst);
+        if (phi == nullptr) {
+            break;
+        }
+        auto *new_phi = target->insert<PhiInst>(phi, phi->incoming_count() - 1 + pred_edge_count);
+        unsigned index = 0;
+        for (unsigned i = 0; i < phi->incoming_count(); i++) {
+            if (phi->incoming_block(i) != block) {
+                new_phi->set_incoming(index++, phi->incoming_block(i), phi->incoming_value(i));
                 continue;
             }
+            for (auto *pred : ir::preds_of(block)) {
+                new_phi->set_incoming(index++, pred, phi->incoming_value(i));
+            }
+        }
+        phi->replace_all_uses_with(new_phi);
+        phi->remove_from_parent();
+    }
+
+    // Every predecessor now jumps straight to the target, and the block itself becomes unreachable.
+    block->replace_all_uses_with(target);
+    if (m_dom_info != nullptr) {
+        m_dom_info->apply_updates(updates.span());
+    }
+    erase_block(block);
+    enqueue(target);
+    for (auto *pred : preds) {
+        enqueue(pred);
+    }
+    return true;
+}
+
+bool CfgSimplifier::merge_successor(BasicBlock *block) {
+    // Check if the block unconditionally branches to a block with no other predecessors. Blocks covered by exception
+    // handlers are left alone, since the PHIs in the handlers would need their entries for both blocks combined.
+    auto *branch = ir::value_cast<BranchInst>(block->terminator());
+    if (branch == nullptr || branch->is_conditional() || !block->handlers().empty()) {
+        return false;
+    }
+    auto *succ = branch->target();
+    if (succ == block || succ == m_function->entry_block() || !succ->handlers().empty() ||
+        std::next(ir::pred_begin(succ)) != ir::pred_end(succ)) {
+        return false;
+    }
+
+    // Any PHIs must be trivial.
+    for (auto *inst : codespy::adapt_mutable_range(*succ)) {
+        auto *phi = ir::value_cast<PhiInst>(inst);
+        if (phi == nullptr) {
+            break;
         }
+        phi->replace_all_uses_with(phi->incoming_value(0));
+        phi->remove_from_parent();
+    }
+
+    // The only remaining uses of the successor are PHIs in its own successors, which now come from the block.
+    branch->remove_from_parent();
+    block->splice(block->end(), succ);
+    succ->replace_all_uses_with(block);
+    if (m_dom_info != nullptr && m_dom_info->is_reachable(succ)) {
+        m_dom_info->merge_block(succ);
     }
-    return changed;
+    m_queued.erase(succ);
+    succ->remove_from_parent();
+    return true;
 }
 
-void simplify_cfg(Function *function) {
-    bool changed;
+void CfgSimplifier::simplify_block(BasicBlock *block) {
+    if (block != m_function->entry_block() && ir::pred_begin(block) == ir::pred_end(block)) {
+        remove_dead_block(block);
+        return;
+    }
+    fold_terminator(block);
+    if (forward_block(block)) {
+        return;
+    }
+    if (merge_successor(block)) {
+        // The block now has the successor's terminator, which might be foldable.
+        enqueue(block);
+    }
+}
+
+void CfgSimplifier::run() {
+    remove_unreachable_blocks();
+
+    // Blocks are popped off the end, so this visits later blocks first. This means that a chain of blocks gets merged
+    // from the bottom up, which avoids repeatedly moving large dominator subtrees.
+    for (auto *block : m_function->blocks()) {
+        enqueue(block);
+    }
+
+    // Folding branches can leave behind unreachable cycles which the local checks can't see, so check for any at the
+    // end and go again if needed.
     do {
-        changed = do_pass(function);
-    } while (changed);
+        while (!m_worklist.empty()) {
+            auto *block = m_worklist.take_last();
+            if (m_queued.erase(block)) {
+                simplify_block(block);
+            }
+        }
+    } while (remove_unreachable_blocks());
+}
+
+} // namespace
+
+void simplify_cfg(Function *function, DominanceInfo *dom_info) {
+    if (function->blocks().empty()) {
+        // No body, e.g. an abstract or external method.
+        return;
+    }
+    CfgSimplifier(function, dom_info).run();
 }
 
 } // namespace codespy::ir
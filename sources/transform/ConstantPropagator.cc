@@ -0,0 +1,576 @@
+#include <codespy/transform/ConstantPropagator.hh>
+
+#include <codespy/container/HashMap.hh>
+#include <codespy/container/HashSet.hh>
+#include <codespy/container/Vector.hh>
+#include <codespy/ir/BasicBlock.hh>
+#include <codespy/ir/Constant.hh>
+#include <codespy/ir/Context.hh>
+#include <codespy/ir/Function.hh>
+#include <codespy/ir/Instructions.hh>
+#include <codespy/ir/Type.hh>
+#include <codespy/support/Optional.hh>
+#include <codespy/support/Utility.hh>
+#include <codespy/transform/CfgSimplifier.hh>
+
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <utility>
+
+namespace codespy::ir {
+namespace {
+
+enum class LatticeState : std::uint8_t {
+    // Not yet known, optimistically assumed to be constant.
+    Unknown,
+    Constant,
+    Overdefined,
+};
+
+struct LatticeValue {
+    LatticeState state{LatticeState::Unknown};
+    Value *constant{nullptr};
+
+    bool operator==(const LatticeValue &) const = default;
+};
+
+using Edge = std::pair<BasicBlock *, BasicBlock *>;
+
+bool is_constant(Value *value) {
+    switch (value->kind()) {
+    case ValueKind::ConstantDouble:
+    case ValueKind::ConstantFloat:
+    case ValueKind::ConstantInt:
+    case ValueKind::ConstantNull:
+    case ValueKind::ConstantString:
+        return true;
+    default:
+        return false;
+    }
+}
+
+// Truncates the value to the width of the type and sign extends it back, which is how integer constants are stored.
+ConstantInt *make_int(Context &context, IntType *type, std::uint64_t value) {
+    const auto shift = 64u - type->bit_width();
+    if (shift != 0) {
+        value = static_cast<std::uint64_t>(static_cast<std::int64_t>(value << shift) >> shift);
+    }
+    return context.constant_int(type, static_cast<std::int64_t>(value));
+}
+
+// NaNs never compare equal and -0.0 compares equal to 0.0, so neither can be reliably interned by value.
+template <typename T>
+bool is_internable(T value) {
+    return !std::isnan(value) && !(value == 0 && std::signbit(value));
+}
+
+Value *make_float(Context &context, Type *type, double value) {
+    if (type->kind() == TypeKind::Float) {
+        const auto float_value = static_cast<float>(value);
+        return is_internable(float_value) ? context.constant_float(float_value) : nullptr;
+    }
+    return is_internable(value) ? context.constant_double(value) : nullptr;
+}
+
+Optional<double> float_value(Value *value) {
+    if (auto *constant = value_cast<ConstantFloat>(value)) {
+        return constant->value();
+    }
+    if (auto *constant = value_cast<ConstantDouble>(value)) {
+        return constant->value();
+    }
+    return {};
+}
+
+// Java's saturating float to integer conversion.
+template <typename T>
+std::int64_t float_to_int(double value) {
+    if (std::isnan(value)) {
+        return 0;
+    }
+    if (value >= static_cast<double>(std::numeric_limits<T>::max())) {
+        return std::numeric_limits<T>::max();
+    }
+    if (value <= static_cast<double>(std::numeric_limits<T>::min())) {
+        return std::numeric_limits<T>::min();
+    }
+    return static_cast<T>(value);
+}
+
+Value *fold_int_binary(Context &context, IntType *type, BinaryOp op, std::int64_t lhs, std::int64_t rhs) {
+    const auto bit_width = type->bit_width();
+    if (bit_width != 32 && bit_width != 64) {
+        return nullptr;
+    }
+    const auto ulhs = static_cast<std::uint64_t>(lhs);
+    const auto urhs = static_cast<std::uint64_t>(rhs);
+    const auto shift = urhs & (bit_width - 1u);
+    switch (op) {
+    case BinaryOp::Add:
+        return make_int(context, type, ulhs + urhs);
+    case BinaryOp::Sub:
+        return make_int(context, type, ulhs - urhs);
+    case BinaryOp::Mul:
+        return make_int(context, type, ulhs * urhs);
+    case BinaryOp::Div:
+    case BinaryOp::Rem:
+        if (rhs == 0) {
+            // Throws ArithmeticException.
+            return nullptr;
+        }
+        if (rhs == -1) {
+            // Avoid overflowing on MIN_VALUE / -1, which wraps back around to MIN_VALUE in Java.
+            return make_int(context, type, op == BinaryOp::Div ? 0 - ulhs : 0);
+        }
+        return make_int(context, type, static_cast<std::uint64_t>(op == BinaryOp::Div ? lhs / rhs : lhs % rhs));
+    case BinaryOp::Shl:
+        return make_int(context, type, ulhs << shift);
+    case BinaryOp::Shr:
+        return make_int(context, type, static_cast<std::uint64_t>(lhs >> shift));
+    case BinaryOp::UShr: {
+        const auto mask = bit_width == 64 ? ~std::uint64_t(0) : (std::uint64_t(1) << bit_width) - 1;
+        return make_int(context, type, (ulhs & mask) >> shift);
+    }
+    case BinaryOp::And:
+        return make_int(context, type, ulhs & urhs);
+    case BinaryOp::Or:
+        return make_int(context, type, ulhs | urhs);
+    case BinaryOp::Xor:
+        return make_int(context, type, ulhs ^ urhs);
+    }
+    codespy::unreachable();
+}
+
+Value *fold_binary(Context &context, BinaryInst *binary, Value *lhs, Value *rhs) {
+    if (binary->type()->kind() == TypeKind::Integer) {
+        auto *int_lhs = value_cast<ConstantInt>(lhs);
+        auto *int_rhs = value_cast<ConstantInt>(rhs);
+        if (int_lhs == nullptr || int_rhs == nullptr) {
+            return nullptr;
+        }
+        return fold_int_binary(context, static_cast<IntType *>(binary->type()), binary->op(), int_lhs->value(),
+                               int_rhs->value());
+    }
+
+    const auto float_lhs = float_value(lhs);
+    const auto float_rhs = float_value(rhs);
+    if (!float_lhs || !float_rhs) {
+        return nullptr;
+    }
+    // Single precision results are exact when computed in double precision and then rounded.
+    switch (binary->op()) {
+    case BinaryOp::Add:
+        return make_float(context, binary->type(), *float_lhs + *float_rhs);
+    case BinaryOp::Sub:
+        return make_float(context, binary->type(), *float_lhs - *float_rhs);
+    case BinaryOp::Mul:
+        return make_float(context, binary->type(), *float_lhs * *float_rhs);
+    case BinaryOp::Div:
+        return make_float(context, binary->type(), *float_lhs / *float_rhs);
+    case BinaryOp::Rem:
+        return make_float(context, binary->type(), std::fmod(*float_lhs, *float_rhs));
+    default:
+        return nullptr;
+    }
+}
+
+Value *fold_cast(Context &context, CastInst *cast, Value *value) {
+    auto *type = cast->type();
+    if (value->kind() == ValueKind::ConstantNull) {
+        // checkcast always succeeds on null.
+        return type->kind() == TypeKind::Reference || type->kind() == TypeKind::Array ? value : nullptr;
+    }
+    const auto *int_value = value_cast<ConstantInt>(value);
+    const auto float_operand = float_value(value);
+    switch (type->kind()) {
+    case TypeKind::Integer: {
+        // Both char and short are lowered to i16, so it isn't known whether to zero or sign extend.
+        auto *int_type = static_cast<IntType *>(type);
+        if (int_type->bit_width() != 8 && int_type->bit_width() != 32 && int_type->bit_width() != 64) {
+            return nullptr;
+        }
+        if (int_value != nullptr) {
+            return make_int(context, int_type, static_cast<std::uint64_t>(int_value->value()));
+        }
+        if (float_operand && int_type->bit_width() != 8) {
+            const auto result = int_type->bit_width() == 32 ? float_to_int<std::int32_t>(*float_operand)
+                                                            : float_to_int<std::int64_t>(*float_operand);
+            return make_int(context, int_type, static_cast<std::uint64_t>(result));
+        }
+        return nullptr;
+    }
+    case TypeKind::Float:
+    case TypeKind::Double:
+        if (int_value != nullptr) {
+            // Convert directly rather than via double to avoid double rounding of large longs to float.
+            if (type->kind() == TypeKind::Float) {
+                return make_float(context, type, static_cast<float>(int_value->value()));
+            }
+            return make_float(context, type, static_cast<double>(int_value->value()));
+        }
+        if (float_operand) {
+            return make_float(context, type, *float_operand);
+        }
+        return nullptr;
+    default:
+        return nullptr;
+    }
+}
+
+Value *fold_compare(Context &context, CompareInst *compare, Value *lhs, Value *rhs) {
+    Optional<bool> result;
+    auto *int_lhs = value_cast<ConstantInt>(lhs);
+    auto *int_rhs = value_cast<ConstantInt>(rhs);
+    if (int_lhs != nullptr && int_rhs != nullptr) {
+        switch (compare->op()) {
+        case CompareOp::Equal:
+            result = int_lhs->value() == int_rhs->value();
+            break;
+        case CompareOp::NotEqual:
+            result = int_lhs->value() != int_rhs->value();
+            break;
+        case CompareOp::LessThan:
+            result = int_lhs->value() < int_rhs->value();
+            break;
+        case CompareOp::GreaterThan:
+            result = int_lhs->value() > int_rhs->value();
+            break;
+        case CompareOp::LessEqual:
+            result = int_lhs->value() <= int_rhs->value();
+            break;
+        case CompareOp::GreaterEqual:
+            result = int_lhs->value() >= int_rhs->value();
+            break;
+        }
+    } else if (compare->op() == CompareOp::Equal || compare->op() == CompareOp::NotEqual) {
+        // Reference comparisons. String constants are interned by the JVM, so identity matches ours.
+        const auto is_reference = [](Value *value) {
+            return value->kind() == ValueKind::ConstantNull || value->kind() == ValueKind::ConstantString;
+        };
+        if (is_reference(lhs) && is_reference(rhs)) {
+            result = (lhs == rhs) == (compare->op() == CompareOp::Equal);
+        }
+    }
+    if (!result) {
+        return nullptr;
+    }
+    return context.constant_int(static_cast<IntType *>(compare->type()), *result ? 1 : 0);
+}
+
+Value *fold_java_compare(Context &context, JavaCompareInst *compare, Value *lhs, Value *rhs) {
+    int result;
+    auto *int_lhs = value_cast<ConstantInt>(lhs);
+    auto *int_rhs = value_cast<ConstantInt>(rhs);
+    const auto float_lhs = float_value(lhs);
+    const auto float_rhs = float_value(rhs);
+    if (int_lhs != nullptr && int_rhs != nullptr) {
+        result = int_lhs->value() < int_rhs->value() ? -1 : int_lhs->value() > int_rhs->value() ? 1 : 0;
+    } else if (float_lhs && float_rhs) {
+        if (std::isnan(*float_lhs) || std::isnan(*float_rhs)) {
+            result = compare->greater_on_nan() ? 1 : -1;
+        } else {
+            result = *float_lhs < *float_rhs ? -1 : *float_lhs > *float_rhs ? 1 : 0;
+        }
+    } else {
+        return nullptr;
+    }
+    return make_int(context, static_cast<IntType *>(compare->type()), static_cast<std::uint64_t>(result));
+}
+
+Value *fold_negate(Context &context, NegateInst *negate, Value *value) {
+    if (auto *int_value = value_cast<ConstantInt>(value)) {
+        if (negate->type()->kind() != TypeKind::Integer) {
+            return nullptr;
+        }
+        return make_int(context, static_cast<IntType *>(negate->type()),
+                        0 - static_cast<std::uint64_t>(int_value->value()));
+    }
+    if (const auto float_operand = float_value(value)) {
+        return make_float(context, negate->type(), -*float_operand);
+    }
+    return nullptr;
+}
+
+class ConstantPropagator {
+    Function *m_function;
+    Context &m_context;
+    PropagateConstantsStats m_stats;
+
+    HashMap<Instruction *, LatticeValue> m_values;
+    HashSet<BasicBlock *> m_executable_blocks;
+    HashSet<Edge> m_executable_edges;
+    Vector<Edge> m_edge_worklist;
+    Vector<Instruction *> m_inst_worklist;
+
+    LatticeValue lattice_value(Value *value);
+    void mark(Instruction *inst, LatticeValue value);
+    void mark_overdefined(Instruction *inst) { mark(inst, {LatticeState::Overdefined}); }
+    void mark_edge(BasicBlock *from, BasicBlock *to) { m_edge_worklist.push(std::make_pair(from, to)); }
+    void visit_phi(PhiInst *phi);
+    void visit_terminator(Instruction *terminator);
+    void visit(Instruction *inst);
+    void visit_block(BasicBlock *block);
+    void solve();
+    bool rewrite();
+
+public:
+    explicit ConstantPropagator(Function *function) : m_function(function), m_context(function->context()) {}
+
+    void run(DominanceInfo *dom_info);
+
+    const PropagateConstantsStats &stats() const { return m_stats; }
+};
+
+LatticeValue ConstantPropagator::lattice_value(Value *value) {
+    if (auto *inst = value_cast<Instruction>(value)) {
+        auto it = m_values.find(inst);
+        return it != m_values.end() ? it->second : LatticeValue{};
+    }
+    if (is_constant(value)) {
+        return {LatticeState::Constant, value};
+    }
+    // Arguments, poison etc.
+    return {LatticeState::Overdefined};
+}
+
+void ConstantPropagator::mark(Instruction *inst, LatticeValue value) {
+    auto &current = m_values[inst];
+    if (current == value || current.state == LatticeState::Overdefined) {
+        return;
+    }
+    current = value;
+    m_inst_worklist.push(inst);
+}
+
+void ConstantPropagator::visit_phi(PhiInst *phi) {
+    LatticeValue result;
+    for (unsigned i = 0; i < phi->incoming_count(); i++) {
+        auto *value = phi->incoming_value(i);
+        if (value == nullptr || !m_executable_edges.contains(std::make_pair(phi->incoming_block(i), phi->parent()))) {
+            continue;
+        }
+        const auto incoming = lattice_value(value);
+        if (incoming.state == LatticeState::Unknown) {
+            continue;
+        }
+        if (incoming.state == LatticeState::Overdefined ||
+            (result.state == LatticeState::Constant && result.constant != incoming.constant)) {
+            mark_overdefined(phi);
+            return;
+        }
+        result = incoming;
+    }
+    if (result.state != LatticeState::Unknown) {
+        mark(phi, result);
+    }
+}
+
+void ConstantPropagator::visit_terminator(Instruction *terminator) {
+    auto *block = terminator->parent();
+    if (auto *branch = value_cast<BranchInst>(terminator)) {
+        if (!branch->is_conditional()) {
+            mark_edge(block, branch->target());
+            return;
+        }
+        const auto condition = lattice_value(branch->condition());
+        if (condition.state == LatticeState::Unknown) {
+            return;
+        }
+        auto *constant =
+            condition.state == LatticeState::Constant ? value_cast<ConstantInt>(condition.constant) : nullptr;
+        if (constant == nullptr) {
+            mark_edge(block, branch->true_target());
+            mark_edge(block, branch->false_target());
+            return;
+        }
+        mark_edge(block, constant->value() != 0 ? branch->true_target() : branch->false_target());
+        return;
+    }
+    if (auto *switch_inst = value_cast<SwitchInst>(terminator)) {
+        const auto value = lattice_value(switch_inst->value());
+        if (value.state == LatticeState::Unknown) {
+            return;
+        }
+        auto *constant = value.state == LatticeState::Constant ? value_cast<ConstantInt>(value.constant) : nullptr;
+        if (constant == nullptr) {
+            mark_edge(block, switch_inst->default_target());
+            for (unsigned i = 0; i < switch_inst->case_count(); i++) {
+                mark_edge(block, switch_inst->case_target(i));
+            }
+            return;
+        }
+        for (unsigned i = 0; i < switch_inst->case_count(); i++) {
+            if (value_cast<ConstantInt>(switch_inst->case_value(i))->value() == constant->value()) {
+                mark_edge(block, switch_inst->case_target(i));
+                return;
+            }
+        }
+        mark_edge(block, switch_inst->default_target());
+    }
+}
+
+void ConstantPropagator::visit(Instruction *inst) {
+    if (auto *phi = value_cast<PhiInst>(inst)) {
+        visit_phi(phi);
+        return;
+    }
+    if (inst->is_terminator()) {
+        visit_terminator(inst);
+        return;
+    }
+
+    switch (inst->opcode()) {
+    case Opcode::Binary:
+    case Opcode::Cast:
+    case Opcode::Compare:
+    case Opcode::JavaCompare:
+    case Opcode::Negate:
+        break;
+    default:
+        mark_overdefined(inst);
+        return;
+    }
+
+    Value *operands[2]{};
+    for (unsigned i = 0; i < inst->operand_count(); i++) {
+        const auto operand = lattice_value(inst->operand(i));
+        if (operand.state == LatticeState::Overdefined) {
+            mark_overdefined(inst);
+            return;
+        }
+        if (operand.state == LatticeState::Unknown) {
+            return;
+        }
+        operands[i] = operand.constant;
+    }
+
+    Value *result = nullptr;
+    switch (inst->opcode()) {
+    case Opcode::Binary:
+        result = fold_binary(m_context, static_cast<BinaryInst *>(inst), operands[0], operands[1]);
+        break;
+    case Opcode::Cast:
+        result = fold_cast(m_context, static_cast<CastInst *>(inst), operands[0]);
+        break;
+    case Opcode::Compare:
+        result = fold_compare(m_context, static_cast<CompareInst *>(inst), operands[0], operands[1]);
+        break;
+    case Opcode::JavaCompare:
+        result = fold_java_compare(m_context, static_cast<JavaCompareInst *>(inst), operands[0], operands[1]);
+        break;
+    case Opcode::Negate:
+        result = fold_negate(m_context, static_cast<NegateInst *>(inst), operands[0]);
+        break;
+    default:
+        codespy::unreachable();
+    }
+    if (result == nullptr) {
+        mark_overdefined(inst);
+        return;
+    }
+    mark(inst, {LatticeState::Constant, result});
+}
+
+void ConstantPropagator::visit_block(BasicBlock *block) {
+    for (auto *inst : *block) {
+        visit(inst);
+    }
+    // Any instruction could throw as far as we're concerned.
+    for (auto *handler : block->handlers()) {
+        mark_edge(block, handler->target());
+    }
+}
+
+void ConstantPropagator::solve() {
+    m_executable_blocks.insert(m_function->entry_block());
+    visit_block(m_function->entry_block());
+    while (!m_edge_worklist.empty() || !m_inst_worklist.empty()) {
+        // Process CFG edges first so that values are only lowered once as much of the CFG as possible is known.
+        while (!m_edge_worklist.empty()) {
+            const auto edge = m_edge_worklist.take_last();
+            if (!m_executable_edges.insert(edge)) {
+                continue;
+            }
+            auto *block = edge.second;
+            if (m_executable_blocks.insert(block)) {
+                visit_block(block);
+                continue;
+            }
+            // Only the PHIs can be affected by a new incoming edge.
+            for (auto *inst : *block) {
+                auto *phi = value_cast<PhiInst>(inst);
+                if (phi == nullptr) {
+                    break;
+                }
+                visit_phi(phi);
+            }
+        }
+        while (!m_inst_worklist.empty()) {
+            auto *inst = m_inst_worklist.take_last();
+            for (auto *user : inst->users()) {
+                auto *user_inst = value_cast<Instruction>(user);
+                if (user_inst != nullptr && m_executable_blocks.contains(user_inst->parent())) {
+                    visit(user_inst);
+                }
+            }
+        }
+    }
+}
+
+bool ConstantPropagator::rewrite() {
+    bool changed = false;
+    for (auto *block : m_function->blocks()) {
+        if (!m_executable_blocks.contains(block)) {
+            // Left for simplify_cfg to remove.
+            m_stats.dead_block_count++;
+            changed = true;
+            continue;
+        }
+        for (auto *inst : codespy::adapt_mutable_range(*block)) {
+            auto it = m_values.find(inst);
+            if (it == m_values.end() || it->second.state != LatticeState::Constant) {
+                continue;
+            }
+            // Replacing a branch condition leaves the branch for simplify_cfg to fold.
+            inst->replace_all_uses_with(it->second.constant);
+            inst->remove_from_parent();
+            m_values.erase(it);
+            m_stats.folded_inst_count++;
+            changed = true;
+        }
+    }
+    return changed;
+}
+
+void ConstantPropagator::run(DominanceInfo *dom_info) {
+    // Size the tables up front for the worst case of everything being executable.
+    std::uint32_t block_count = 0;
+    std::uint32_t inst_count = 0;
+    for (auto *block : m_function->blocks()) {
+        block_count++;
+        for ([[maybe_unused]] auto *inst : *block) {
+            inst_count++;
+        }
+    }
+    m_values.ensure_capacity(inst_count);
+    m_executable_blocks.ensure_capacity(block_count);
+    solve();
+    if (rewrite()) {
+        ir::simplify_cfg(m_function, dom_info);
+    }
+}
+
+} // namespace
+
+PropagateConstantsStats propagate_constants(Function *function, DominanceInfo *dom_info) {
+    if (function->blocks().empty()) {
+        // No body, e.g. an abstract or external method.
+        return {};
+    }
+    ConstantPropagator propagator(function);
+    propagator.run(dom_info);
+    return propagator.stats();
+}
+
+} // namespace codespy::ir
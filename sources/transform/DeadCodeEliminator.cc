@@ -0,0 +1,161 @@
+#include <codespy/transform/DeadCodeEliminator.hh>
+
+#include <codespy/container/HashSet.hh>
+#include <codespy/container/Vector.hh>
+#include <codespy/ir/BasicBlock.hh>
+#include <codespy/ir/Function.hh>
+#include <codespy/ir/Instructions.hh>
+#include <codespy/ir/Java.hh>
+
+#include <algorithm>
+#include <cstdint>
+
+namespace codespy::ir {
+namespace {
+
+bool is_removable(Instruction *inst) {
+    switch (inst->opcode()) {
+    case Opcode::Catch:
+    case Opcode::ExceptionHandler:
+    case Opcode::Monitor:
+    case Opcode::Store:
+    case Opcode::StoreArray:
+    case Opcode::StoreField:
+        return false;
+    case Opcode::LoadField:
+        // Static field loads can only throw if class initialisation fails, which we don't care about preserving.
+        return !static_cast<LoadFieldInst *>(inst)->field()->is_instance();
+    default:
+        return !inst->is_terminator() && !inst->may_throw();
+    }
+}
+
+class DeadCodeEliminator {
+    Function *m_function;
+    DceStats m_stats;
+    Vector<Instruction *> m_worklist;
+    // Scratch space for the instruction operands of the instruction being removed.
+    Vector<Instruction *> m_operands;
+
+    void remove(Instruction *inst);
+    void run_use_count();
+    void run_aggressive();
+
+public:
+    explicit DeadCodeEliminator(Function *function) : m_function(function) {}
+
+    void run(DceMode mode);
+
+    const DceStats &stats() const { return m_stats; }
+};
+
+void DeadCodeEliminator::remove(Instruction *inst) {
+    if (value_is<PhiInst>(inst)) {
+        m_stats.removed_phi_count++;
+    } else {
+        m_stats.removed_inst_count++;
+    }
+    inst->remove_from_parent();
+}
+
+void DeadCodeEliminator::run_use_count() {
+    for (auto *block : m_function->blocks()) {
+        for (auto *inst : *block) {
+            if (!inst->has_uses() && is_removable(inst)) {
+                m_worklist.push(inst);
+            }
+        }
+    }
+
+    // An instruction is only queued once its last use goes away, which can only happen once since nothing gains
+    // uses here, so the worklist never holds duplicates.
+    while (!m_worklist.empty()) {
+        auto *inst = m_worklist.take_last();
+        m_operands.clear();
+        for (unsigned i = 0; i < inst->operand_count(); i++) {
+            auto *operand = inst->operand(i);
+            if (operand == nullptr || operand == inst) {
+                continue;
+            }
+            if (auto *operand_inst = value_cast<Instruction>(operand)) {
+                m_operands.push(operand_inst);
+            }
+        }
+        remove(inst);
+
+        // The same value may be used more than once by the removed instruction.
+        std::sort(m_operands.begin(), m_operands.end());
+        Instruction *previous = nullptr;
+        for (auto *operand : m_operands) {
+            if (operand != previous && !operand->has_uses() && is_removable(operand)) {
+                m_worklist.push(operand);
+            }
+            previous = operand;
+        }
+    }
+}
+
+void DeadCodeEliminator::run_aggressive() {
+    // Size the live set for the worst case of nothing being dead.
+    std::uint32_t inst_count = 0;
+    for (auto *block : m_function->blocks()) {
+        for ([[maybe_unused]] auto *inst : *block) {
+            inst_count++;
+        }
+    }
+    HashSet<Instruction *> live;
+    live.ensure_capacity(inst_count);
+    for (auto *block : m_function->blocks()) {
+        for (auto *inst : *block) {
+            if (!is_removable(inst)) {
+                live.insert(inst);
+                m_worklist.push(inst);
+            }
+        }
+    }
+
+    while (!m_worklist.empty()) {
+        auto *inst = m_worklist.take_last();
+        for (unsigned i = 0; i < inst->operand_count(); i++) {
+            auto *operand = inst->operand(i);
+            if (operand == nullptr) {
+                continue;
+            }
+            auto *operand_inst = value_cast<Instruction>(operand);
+            if (operand_inst != nullptr && live.insert(operand_inst)) {
+                m_worklist.push(operand_inst);
+            }
+        }
+    }
+
+    // Anything dead can only be used by other dead instructions, so the removal order doesn't matter. Uses of an
+    // already removed value are nulled out by its destructor.
+    for (auto *block : m_function->blocks()) {
+        for (auto *inst : codespy::adapt_mutable_range(*block)) {
+            if (!live.contains(inst)) {
+                remove(inst);
+            }
+        }
+    }
+}
+
+void DeadCodeEliminator::run(DceMode mode) {
+    switch (mode) {
+    case DceMode::UseCount:
+        run_use_count();
+        break;
+    case DceMode::Aggressive:
+        run_aggressive();
+        break;
+    }
+}
+
+} // namespace
+
+DceStats eliminate_dead_code(Function *function, DceMode mode) {
+    DeadCodeEliminator eliminator(function);
+    eliminator.run(mode);
+    return eliminator.stats();
+}
+
+} // namespace codespy::ir
@@ -7,16 +7,47 @@
 #include <codespy/ir/Function.hh>
 #include <codespy/ir/Instructions.hh>
 
+#include <iterator>
+
 namespace codespy::ir {
 
 void prune_exceptions(Function *function) {
     Type *runtime_exception_type = function->context().reference_type("java/lang/RuntimeException");
-    for (auto *block : function->blocks()) {
+    for (auto *block : codespy::adapt_mutable_range(function->blocks())) {
         for (auto *handler : codespy::adapt_mutable_range(block->handlers())) {
             if (handler->type() == runtime_exception_type) {
                 handler->remove_from_parent();
             }
         }
+        if (block->handlers().empty()) {
+            continue;
+        }
+
+        // Find the last instruction which can throw. If there isn't one, the handlers are unreachable from this block.
+        auto last_throwing = block->end();
+        for (auto it = block->begin(); it != block->end(); ++it) {
+            if (it->may_throw()) {
+                last_throwing = it;
+            }
+        }
+        if (last_throwing == block->end()) {
+            for (auto *handler : codespy::adapt_mutable_range(block->handlers())) {
+                handler->remove_from_parent();
+            }
+            continue;
+        }
+
+        // Stores to locals after the last throwing instruction can't be observed by the handlers, but would make their
+        // incoming values more imprecise once promoted. Split them off into a block without any handlers.
+        bool needs_split = false;
+        for (auto it = std::next(last_throwing); it != block->end(); ++it) {
+            if (auto *store = ir::value_cast<StoreInst>(*it)) {
+                needs_split |= ir::value_is<Local>(store->pointer());
+            }
+        }
+        if (needs_split) {
+            block->split(std::next(last_throwing));
+        }
     }
 }
 
@@ -1,37 +1,67 @@
 #include <codespy/transform/LocalPromoter.hh>
 
+#include <codespy/container/HashSet.hh>
 #include <codespy/container/Vector.hh>
-#include <codespy/ir/Cfg.hh>
+#include <codespy/ir/BasicBlock.hh>
+#include <codespy/ir/CfgSnapshot.hh>
 #include <codespy/ir/Context.hh>
 #include <codespy/ir/Dominance.hh>
 #include <codespy/ir/Function.hh>
 #include <codespy/ir/Instructions.hh>
+#include <codespy/ir/Liveness.hh>
+#include <codespy/ir/MutationBatch.hh>
 
-#include <unordered_map>
-#include <unordered_set>
+#include <utility>
 
 namespace codespy::ir {
 namespace {
 
+constexpr unsigned k_invalid_index = ~0u;
+
 struct PhiInfo {
-    Local *local;
+    PhiInst *phi;
+    unsigned local;
     unsigned incoming_index{0};
 };
 
 class LocalPromoter {
     Function *m_function;
-    DominanceInfo m_dom_info;
-    std::unordered_map<Local *, Vector<Value *>> m_reaching_value_map;
-    std::unordered_map<PhiInst *, PhiInfo> m_phi_info_map;
-    std::unordered_set<BasicBlock *> m_visited_blocks;
+    const CfgSnapshot &m_cfg;
+    const DominanceInfo &m_dom_info;
+    const LocalLiveness &m_liveness;
+    PromoteLocalsStats m_stats;
+
+    // Loads and stores are only removed once everything has been renamed, so that blocks can be walked normally.
+    MutationBatch m_batch;
+
+    // The PHIs inserted by us indexed by snapshot block id, and dense indices of the non-trivial locals. Local indices
+    // are looked up by Local::index() to avoid hashing on every load and store.
+    Vector<Vector<PhiInfo>> m_block_phis;
+    Vector<Local *> m_locals;
+    Vector<unsigned> m_local_indices;
+
+    // The current reaching definition of each local, and a stack of (local, previous definition) pairs to restore
+    // when leaving a dominator subtree.
+    Vector<Value *> m_reaching_values;
+    Vector<std::pair<unsigned, Value *>> m_reaching_value_stack;
+
+    unsigned local_index(Value *pointer) const;
+    void place_phis();
+    void define(unsigned local, Value *value);
+    void rename_block(BasicBlock *block);
+    void rename();
+    Value *trivial_phi_value(PhiInst *phi) const;
+    void remove_trivial_phis();
 
 public:
-    LocalPromoter(Function *function, DominanceInfo &&dom_info)
-        : m_function(function), m_dom_info(std::move(dom_info)) {}
+    LocalPromoter(Function *function, const CfgSnapshot &cfg, const DominanceInfo &dom_info,
+                  const LocalLiveness &liveness)
+        : m_function(function), m_cfg(cfg), m_dom_info(dom_info), m_liveness(liveness) {}
 
     bool handle_trivial_local(Local *local);
-    void rename_recursive(BasicBlock *block);
     void run();
+
+    const PromoteLocalsStats &stats() const { return m_stats; }
 };
 
 bool LocalPromoter::handle_trivial_local(Local *local) {
@@ -60,10 +90,9 @@ bool LocalPromoter::handle_trivial_local(Local *local) {
 
     // No stores, every use is undefined.
     if (has_single_store && single_store == nullptr) {
-        for (auto *user : codespy::adapt_mutable_range(local->users())) {
+        for (auto *user : local->users()) {
             if (auto *load = ir::value_cast<LoadInst>(user)) {
-                load->replace_all_uses_with(m_function->context().poison_value(load->type()));
-                load->remove_from_parent();
+                m_batch.replace_and_remove(load, m_function->context().poison_value(load->type()));
             }
         }
         return true;
@@ -72,16 +101,15 @@ bool LocalPromoter::handle_trivial_local(Local *local) {
     if (has_single_store) {
         // Single store implies that every use can only ever resolve to the stored value or undef, depending on whether
         // the store dominates the use or not respectively.
-        for (auto *user : codespy::adapt_mutable_range(local->users())) {
+        for (auto *user : local->users()) {
             if (auto *load = ir::value_cast<LoadInst>(user)) {
                 auto *reaching_value = m_dom_info.dominates(single_store, load)
                                            ? single_store->value()
                                            : m_function->context().poison_value(load->type());
-                load->replace_all_uses_with(reaching_value);
-                load->remove_from_parent();
+                m_batch.replace_and_remove(load, reaching_value);
             }
         }
-        single_store->remove_from_parent();
+        m_batch.remove(single_store);
         return true;
     }
 
@@ -91,122 +119,200 @@ bool LocalPromoter::handle_trivial_local(Local *local) {
 
     // Symbolic execution of memory operations.
     Value *reaching_value = nullptr;
-    for (auto *inst : codespy::adapt_mutable_range(*single_block)) {
+    for (auto *inst : *single_block) {
         if (auto *load = ir::value_cast<LoadInst>(inst)) {
             if (load->pointer() == local) {
-                load->replace_all_uses_with(
-                    reaching_value != nullptr ? reaching_value : m_function->context().poison_value(load->type()));
-                load->remove_from_parent();
+                auto *poison = m_function->context().poison_value(load->type());
+                m_batch.replace_and_remove(load, reaching_value != nullptr ? reaching_value : poison);
             }
         } else if (auto *store = ir::value_cast<StoreInst>(inst)) {
             if (store->pointer() == local) {
                 reaching_value = store->value();
-                store->remove_from_parent();
+                m_batch.remove(store);
             }
         }
     }
     return true;
 }
 
-void LocalPromoter::rename_recursive(BasicBlock *block) {
-    if (!m_visited_blocks.insert(block).second) {
-        return;
+unsigned LocalPromoter::local_index(Value *pointer) const {
+    auto *local = ir::value_cast<Local>(pointer);
+    return local != nullptr ? m_local_indices[local->index()] : k_invalid_index;
+}
+
+void LocalPromoter::place_phis() {
+    // Insert PHIs at the iterated dominance frontier of the stores. Only insert them where the local is actually live
+    // though, to avoid creating lots of dead PHIs for stack slots.
+    IteratedFrontier iterated_frontier(m_cfg, m_dom_info);
+    m_block_phis.ensure_capacity(m_cfg.block_count());
+    for (std::uint32_t i = 0; i < m_cfg.block_count(); i++) {
+        m_block_phis.emplace();
+    }
+    for (unsigned local_index = 0; local_index < m_locals.size(); local_index++) {
+        Vector<std::uint32_t> def_blocks;
+        for (auto *user : m_locals[local_index]->users()) {
+            auto *store = ir::value_cast<StoreInst>(user);
+            if (store != nullptr && m_cfg.contains(store->parent())) {
+                def_blocks.push(m_cfg.id(store->parent()));
+            }
+        }
+        for (auto block_id : iterated_frontier.compute(def_blocks.span())) {
+            m_stats.minimal_phi_count++;
+            if (!m_liveness.is_live_in(block_id, m_locals[local_index])) {
+                continue;
+            }
+            m_stats.pruned_phi_count++;
+            auto *phi = m_cfg.block(block_id)->prepend<PhiInst>(m_cfg.preds(block_id).size());
+            m_block_phis[block_id].push(PhiInfo{.phi = phi, .local = local_index});
+        }
+    }
+}
+
+void LocalPromoter::define(unsigned local, Value *value) {
+    m_reaching_value_stack.push(std::make_pair(local, m_reaching_values[local]));
+    m_reaching_values[local] = value;
+}
+
+void LocalPromoter::rename_block(BasicBlock *block) {
+    const auto block_id = m_cfg.id(block);
+    for (const auto &phi_info : m_block_phis[block_id]) {
+        define(phi_info.local, phi_info.phi);
     }
 
     // Symbolic execution of memory operations.
     // TODO: Assuming all locals promotable here, may not be in the future.
     for (auto *inst : *block) {
         if (auto *load = ir::value_cast<LoadInst>(inst)) {
-            if (auto *local = ir::value_cast<Local>(load->pointer())) {
-                load->replace_all_uses_with(m_reaching_value_map.at(local).last());
+            if (const auto index = local_index(load->pointer()); index != k_invalid_index) {
+                m_batch.replace_and_remove(load, m_reaching_values[index]);
             }
         } else if (auto *store = ir::value_cast<StoreInst>(inst)) {
-            if (auto *local = ir::value_cast<Local>(store->pointer())) {
-                m_reaching_value_map.at(local).push(store->value());
+            if (const auto index = local_index(store->pointer()); index != k_invalid_index) {
+                // The stored value may be a load which has already been queued for replacement.
+                define(index, m_batch.resolve(store->value()));
+                m_batch.remove(store);
             }
-        } else if (auto *phi = ir::value_cast<PhiInst>(inst); m_phi_info_map.contains(phi)) {
-            const auto &info = m_phi_info_map.at(phi);
-            m_reaching_value_map.at(info.local).push(phi);
         }
     }
 
     // Update successor PHIs with reaching values.
-    for (auto *succ : ir::succs_of(block)) {
-        for (auto *inst : *succ) {
-            auto *phi = ir::value_cast<PhiInst>(inst);
-            if (phi == nullptr) {
-                // PHIs must be contiguous at the top of a block, so the first non-PHI we see indicates no more
-                // PHIs are left.
-                break;
-            }
-            if (!m_phi_info_map.contains(phi)) {
-                // PHI not inserted by us.
-                continue;
-            }
-            auto &info = m_phi_info_map.at(phi);
-            auto *reaching_value = m_reaching_value_map.at(info.local).last();
-            phi->set_incoming(info.incoming_index++, block, reaching_value);
+    for (auto succ : m_cfg.succs(block_id)) {
+        for (auto &phi_info : m_block_phis[succ]) {
+            phi_info.phi->set_incoming(phi_info.incoming_index++, block, m_reaching_values[phi_info.local]);
         }
     }
+}
 
-    // Recurse over successors.
-    for (auto *succ : ir::succs_of(block)) {
-        rename_recursive(succ);
+void LocalPromoter::rename() {
+    m_reaching_values.ensure_capacity(m_locals.size());
+    for (auto *local : m_locals) {
+        m_reaching_values.push(m_function->context().poison_value(local->type()));
     }
 
-    for (auto *inst : codespy::adapt_mutable_range(*block)) {
-        if (auto *load = ir::value_cast<LoadInst>(inst)) {
-            if (ir::value_is<Local>(load->pointer())) {
-                load->remove_from_parent();
-            }
-        } else if (auto *store = ir::value_cast<StoreInst>(inst)) {
-            if (auto *local = ir::value_cast<Local>(store->pointer())) {
-                m_reaching_value_map.at(local).pop();
-                store->remove_from_parent();
-            }
-        } else if (auto *phi = ir::value_cast<PhiInst>(inst); m_phi_info_map.contains(phi)) {
-            const auto &info = m_phi_info_map.at(phi);
-            m_reaching_value_map.at(info.local).pop();
+    // Preorder walk of the dominator tree, so that every block sees the definitions of its dominators.
+    struct Frame {
+        BasicBlock *block;
+        unsigned child_index;
+        std::uint32_t stack_size;
+    };
+    Vector<Frame> stack;
+    auto enter = [&](BasicBlock *block) {
+        stack.push(Frame{block, 0, m_reaching_value_stack.size()});
+        rename_block(block);
+    };
+    enter(m_function->entry_block());
+    while (!stack.empty()) {
+        auto &frame = stack.last();
+        const auto &children = m_dom_info.children(frame.block);
+        if (frame.child_index < children.size()) {
+            enter(children[frame.child_index++]);
+            continue;
+        }
+
+        // Restore the definitions reaching the parent.
+        while (m_reaching_value_stack.size() > frame.stack_size) {
+            const auto [local, value] = m_reaching_value_stack.take_last();
+            m_reaching_values[local] = value;
         }
+        stack.pop();
     }
 }
 
-void LocalPromoter::run() {
-    for (auto *local : codespy::adapt_mutable_range(m_function->locals())) {
-        if (handle_trivial_local(local)) {
-            m_function->remove_local(local);
+// Returns the value a PHI can be replaced with, or nullptr if it merges different values. Poison incoming values are
+// ignored, but only if the other value is available at the PHI, since it may otherwise be defined inside a loop.
+Value *LocalPromoter::trivial_phi_value(PhiInst *phi) const {
+    Value *same = nullptr;
+    bool has_poison = false;
+    for (unsigned i = 0; i < phi->incoming_count(); i++) {
+        auto *value = phi->incoming_value(i);
+        if (value == phi) {
             continue;
         }
-
-        // Otherwise there are multiple stores, need to insert PHIs at join points.
-        std::unordered_set<BasicBlock *> visited;
-        for (auto *user : local->users()) {
-            auto *store = ir::value_cast<StoreInst>(user);
-            if (store == nullptr) {
-                continue;
-            }
-            for (auto *df : m_dom_info.frontiers(store->parent())) {
-                if (!visited.insert(df).second) {
-                    continue;
-                }
-                const auto pred_count = std::distance(ir::pred_begin(df), ir::pred_end(df));
-                auto *phi = df->prepend<PhiInst>(pred_count);
-                m_phi_info_map.emplace(phi, PhiInfo{.local = local});
-            }
+        if (ir::value_is<PoisonValue>(value)) {
+            has_poison = true;
+            continue;
+        }
+        if (same != nullptr && value != same) {
+            return nullptr;
         }
+        same = value;
     }
+    if (same == nullptr) {
+        return m_function->context().poison_value(phi->type());
+    }
+    if (auto *inst = ir::value_cast<Instruction>(same); has_poison && inst != nullptr) {
+        return m_dom_info.strictly_dominates(inst->parent(), phi->parent()) ? same : nullptr;
+    }
+    return same;
+}
 
-    if (m_function->locals().empty()) {
-        // No locals left, nothing else to do.
-        return;
+void LocalPromoter::remove_trivial_phis() {
+    // Removing a PHI can make any PHI using it trivial too, so keep going until nothing changes.
+    Vector<PhiInst *> worklist;
+    HashSet<PhiInst *> queued;
+    for (const auto &phis : m_block_phis) {
+        for (const auto &phi_info : phis) {
+            worklist.push(phi_info.phi);
+            queued.insert(phi_info.phi);
+        }
     }
+    while (!worklist.empty()) {
+        auto *phi = worklist.take_last();
+        queued.erase(phi);
+        auto *value = trivial_phi_value(phi);
+        if (value == nullptr) {
+            continue;
+        }
+        for (auto *user : phi->users()) {
+            auto *user_phi = ir::value_cast<PhiInst>(user);
+            if (user_phi != nullptr && user_phi != phi && queued.insert(user_phi)) {
+                worklist.push(user_phi);
+            }
+        }
+        phi->replace_all_uses_with(value);
+        phi->remove_from_parent();
+        m_stats.trivial_phi_count++;
+    }
+}
 
+void LocalPromoter::run() {
+    // Trivial locals are left in place with no uses once the batch is applied, and are then deleted below.
     for (auto *local : m_function->locals()) {
-        m_reaching_value_map[local].push(m_function->context().poison_value(local->type()));
+        if (!handle_trivial_local(local)) {
+            m_locals.push(local);
+        }
     }
 
-    // Rename pass.
-    rename_recursive(m_function->entry_block());
+    if (!m_locals.empty()) {
+        m_local_indices.ensure_size(m_function->local_count(), k_invalid_index);
+        for (unsigned i = 0; i < m_locals.size(); i++) {
+            m_local_indices[m_locals[i]->index()] = i;
+        }
+        place_phis();
+        rename();
+    }
+    m_batch.apply();
+    remove_trivial_phis();
 
     // Delete any dead locals.
     for (auto *local : codespy::adapt_mutable_range(m_function->locals())) {
@@ -218,9 +324,24 @@ void LocalPromoter::run() {
 
 } // namespace
 
-void promote_locals(Function *function) {
-    auto dom_info = ir::compute_dominance(function);
-    LocalPromoter(function, std::move(dom_info)).run();
+PromoteLocalsStats promote_locals(Function *function) {
+    const CfgSnapshot cfg(function);
+    return promote_locals(function, cfg, ir::compute_dominance(cfg));
+}
+
+PromoteLocalsStats promote_locals(Function *function, const DominanceInfo &dom_info) {
+    return promote_locals(function, CfgSnapshot(function), dom_info);
+}
+
+PromoteLocalsStats promote_locals(Function *function, const CfgSnapshot &cfg, const DominanceInfo &dom_info) {
+    return promote_locals(function, cfg, dom_info, LocalLiveness(cfg));
+}
+
+PromoteLocalsStats promote_locals(Function *function, const CfgSnapshot &cfg, const DominanceInfo &dom_info,
+                                  const LocalLiveness &liveness) {
+    LocalPromoter promoter(function, cfg, dom_info, liveness);
+    promoter.run();
+    return promoter.stats();
 }
 
 } // namespace codespy::ir
@@ -0,0 +1,142 @@
+#include <codespy/transform/PassManager.hh>
+
+#include <codespy/container/Array.hh>
+#include <codespy/ir/CfgSnapshot.hh>
+#include <codespy/ir/Dominance.hh>
+#include <codespy/ir/Function.hh>
+#include <codespy/ir/Liveness.hh>
+#include <codespy/transform/CfgSimplifier.hh>
+#include <codespy/transform/ConstantPropagator.hh>
+#include <codespy/transform/DeadCodeEliminator.hh>
+#include <codespy/transform/ExceptionPruner.hh>
+#include <codespy/transform/LocalPromoter.hh>
+#include <codespy/transform/ValueNumbering.hh>
+
+#include <utility>
+
+namespace codespy::ir {
+namespace {
+
+PreservedAnalyses run_prune_exceptions(Function *function, AnalysisManager &, Vector<PassStatistic> &) {
+    ir::prune_exceptions(function);
+    return PreservedAnalyses::none();
+}
+
+PreservedAnalyses run_simplify_cfg(Function *function, AnalysisManager &analyses, Vector<PassStatistic> &) {
+    // Any existing dominator tree is kept up to date, but don't bother computing one just for this.
+    ir::simplify_cfg(function, analyses.get_cached<DominanceInfo>());
+    return PreservedAnalyses::none().preserve(AnalysisKind::Dominance);
+}
+
+PreservedAnalyses run_promote_locals(Function *function, AnalysisManager &analyses,
+                                     Vector<PassStatistic> &statistics) {
+    // Only instructions are changed, the CFG stays the same. Loads and stores of locals are removed though.
+    const auto &dom_info = analyses.get<DominanceInfo>();
+    const auto &liveness = analyses.get<LocalLiveness>();
+    const auto stats = ir::promote_locals(function, analyses.get<CfgSnapshot>(), dom_info, liveness);
+    statistics.push({"minimal-phis", stats.minimal_phi_count});
+    statistics.push({"pruned-phis", stats.pruned_phi_count});
+    statistics.push({"trivial-phis", stats.trivial_phi_count});
+    return PreservedAnalyses::none().preserve(AnalysisKind::CfgSnapshot).preserve(AnalysisKind::Dominance);
+}
+
+PreservedAnalyses run_sccp(Function *function, AnalysisManager &analyses, Vector<PassStatistic> &statistics) {
+    const auto stats = ir::propagate_constants(function, analyses.get_cached<DominanceInfo>());
+    statistics.push({"folded-insts", stats.folded_inst_count});
+    statistics.push({"dead-blocks", stats.dead_block_count});
+    return PreservedAnalyses::none().preserve(AnalysisKind::Dominance);
+}
+
+PreservedAnalyses run_gvn(Function *function, AnalysisManager &analyses, Vector<PassStatistic> &statistics) {
+    // Keep the table around between functions. It's per thread since pipelines may run in the background.
+    thread_local ValueNumbering value_numbering;
+    statistics.push({"replaced-insts", value_numbering.run(function, analyses.get<DominanceInfo>())});
+    // Loads aren't numbered, so liveness of locals is unaffected.
+    return PreservedAnalyses::none()
+        .preserve(AnalysisKind::CfgSnapshot)
+        .preserve(AnalysisKind::Dominance)
+        .preserve(AnalysisKind::Liveness);
+}
+
+template <DceMode Mode>
+PreservedAnalyses run_dce(Function *function, AnalysisManager &, Vector<PassStatistic> &statistics) {
+    const auto stats = ir::eliminate_dead_code(function, Mode);
+    statistics.push({"removed-insts", stats.removed_inst_count});
+    statistics.push({"removed-phis", stats.removed_phi_count});
+    // Dead loads of locals may have been removed, so liveness isn't preserved.
+    return PreservedAnalyses::none().preserve(AnalysisKind::CfgSnapshot).preserve(AnalysisKind::Dominance);
+}
+
+const Array k_builtin_passes{
+    Pass{"prune-exceptions", &run_prune_exceptions},
+    Pass{"simplify-cfg", &run_simplify_cfg},
+    Pass{"promote-locals", &run_promote_locals},
+    Pass{"sccp", &run_sccp},
+    Pass{"gvn", &run_gvn},
+    Pass{"dce", &run_dce<DceMode::UseCount>},
+    Pass{"aggressive-dce", &run_dce<DceMode::Aggressive>},
+};
+
+} // namespace
+
+Vector<PassRecord> PassManager::run(Function *function) const {
+    Vector<PassRecord> records;
+    if (function->blocks().empty()) {
+        // Nothing to optimise in a method without a body.
+        return records;
+    }
+    AnalysisManager analyses(function);
+    records.ensure_capacity(m_passes.size());
+    for (const auto &pass : m_passes) {
+        Vector<PassStatistic> statistics;
+        const auto start_time = std::chrono::steady_clock::now();
+        analyses.invalidate(pass.run(function, analyses, statistics));
+        records.push({pass.name, std::chrono::steady_clock::now() - start_time, std::move(statistics)});
+    }
+    return records;
+}
+
+const Pass *find_pass(StringView name) {
+    for (const auto &pass : k_builtin_passes) {
+        if (pass.name == name) {
+            return &pass;
+        }
+    }
+    return nullptr;
+}
+
+StringView pipeline_spec(OptLevel level) {
+    switch (level) {
+    case OptLevel::O0:
+        return "";
+    case OptLevel::O1:
+        return "prune-exceptions,simplify-cfg";
+    case OptLevel::O2:
+        return "prune-exceptions,simplify-cfg,promote-locals,sccp,gvn,aggressive-dce,simplify-cfg";
+    }
+    codespy::unreachable();
+}
+
+Result<void, PipelineError> parse_pipeline(StringView spec, PassManager &pass_manager) {
+    if (spec.empty()) {
+        return {};
+    }
+    std::size_t begin = 0;
+    while (true) {
+        std::size_t end = begin;
+        while (end < spec.length() && spec[end] != ',') {
+            end++;
+        }
+        const auto *pass = find_pass(spec.substr(begin, end));
+        if (pass == nullptr) {
+            return PipelineError::UnknownPass;
+        }
+        pass_manager.add_pass(*pass);
+        if (end == spec.length()) {
+            return {};
+        }
+        begin = end + 1;
+    }
+}
+
+} // namespace codespy::ir
@@ -0,0 +1,181 @@
+#include <codespy/transform/ValueNumbering.hh>
+
+#include <codespy/ir/BasicBlock.hh>
+#include <codespy/ir/Dominance.hh>
+#include <codespy/ir/Function.hh>
+#include <codespy/ir/Instructions.hh>
+#include <codespy/support/Hash.hh>
+#include <codespy/support/Optional.hh>
+#include <codespy/support/Utility.hh>
+
+#include <algorithm>
+#include <bit>
+#include <functional>
+#include <utility>
+
+namespace codespy::ir {
+
+bool ValueNumbering::make_key(Instruction *inst, Key &key) {
+    key = {inst->opcode(), inst->type(), 0, nullptr, nullptr};
+    switch (inst->opcode()) {
+    case Opcode::ArrayLength:
+        // Array lengths are immutable, and a dominating copy would have already thrown on a null array.
+        key.lhs = static_cast<ArrayLengthInst *>(inst)->array_ref();
+        return true;
+    case Opcode::Binary: {
+        auto *binary = static_cast<BinaryInst *>(inst);
+        key.attribute = static_cast<std::uintptr_t>(binary->op());
+        key.lhs = binary->lhs();
+        key.rhs = binary->rhs();
+        switch (binary->op()) {
+        case BinaryOp::Add:
+        case BinaryOp::Mul:
+        case BinaryOp::And:
+        case BinaryOp::Or:
+        case BinaryOp::Xor:
+            if (std::less<Value *>{}(key.rhs, key.lhs)) {
+                std::swap(key.lhs, key.rhs);
+            }
+            break;
+        default:
+            break;
+        }
+        return true;
+    }
+    case Opcode::Cast:
+        key.lhs = static_cast<CastInst *>(inst)->value();
+        return true;
+    case Opcode::Compare: {
+        auto *compare = static_cast<CompareInst *>(inst);
+        key.attribute = static_cast<std::uintptr_t>(compare->op());
+        key.lhs = compare->lhs();
+        key.rhs = compare->rhs();
+        if ((compare->op() == CompareOp::Equal || compare->op() == CompareOp::NotEqual) &&
+            std::less<Value *>{}(key.rhs, key.lhs)) {
+            std::swap(key.lhs, key.rhs);
+        }
+        return true;
+    }
+    case Opcode::InstanceOf: {
+        auto *instance_of = static_cast<InstanceOfInst *>(inst);
+        key.attribute = reinterpret_cast<std::uintptr_t>(instance_of->check_type());
+        key.lhs = instance_of->value();
+        return true;
+    }
+    case Opcode::JavaCompare: {
+        // The operand type is already implied by the operands, only the NaN behaviour needs distinguishing.
+        auto *compare = static_cast<JavaCompareInst *>(inst);
+        key.attribute = compare->greater_on_nan() ? 1 : 0;
+        key.lhs = compare->lhs();
+        key.rhs = compare->rhs();
+        return true;
+    }
+    case Opcode::Negate:
+        key.lhs = static_cast<NegateInst *>(inst)->value();
+        return true;
+    default:
+        return false;
+    }
+}
+
+std::size_t ValueNumbering::hash_key(const Key &key) {
+    auto hash = static_cast<std::size_t>(key.opcode);
+    hash = codespy::hash_combine(hash, reinterpret_cast<std::uintptr_t>(key.type));
+    hash = codespy::hash_combine(hash, key.attribute);
+    hash = codespy::hash_combine(hash, reinterpret_cast<std::uintptr_t>(key.lhs));
+    return codespy::hash_combine(hash, reinterpret_cast<std::uintptr_t>(key.rhs));
+}
+
+void ValueNumbering::ensure_capacity(std::uint32_t inst_count) {
+    // Keep the load factor at or below a half even if every instruction ends up in the table at once.
+    const auto capacity = std::bit_ceil(std::max(inst_count * 2, 16u));
+    if (capacity > m_table.size()) {
+        m_table = Vector<Entry>(capacity);
+    }
+}
+
+void ValueNumbering::number_block(BasicBlock *block) {
+    // Values computed from the first throwing instruction onwards aren't available in any handler this block may
+    // dominate, so they need to be forgotten once the block is done.
+    const bool has_handlers = !block->handlers().empty();
+    Optional<std::uint32_t> block_local_begin;
+
+    const auto mask = m_table.size() - 1;
+    for (auto *inst : codespy::adapt_mutable_range(*block)) {
+        Key key;
+        const bool has_key = make_key(inst, key);
+        std::uint32_t slot = 0;
+        if (has_key) {
+            slot = static_cast<std::uint32_t>(hash_key(key) & mask);
+            while (m_table[slot].inst != nullptr && m_table[slot].key != key) {
+                slot = (slot + 1) & mask;
+            }
+            if (auto *leader = m_table[slot].inst) {
+                inst->replace_all_uses_with(leader);
+                inst->remove_from_parent();
+                m_replaced_count++;
+                continue;
+            }
+        }
+        if (has_handlers && !block_local_begin && inst->may_throw()) {
+            block_local_begin = m_inserted_slots.size();
+        }
+        if (has_key) {
+            m_table[slot] = {key, inst};
+            m_inserted_slots.push(slot);
+        }
+    }
+
+    if (block_local_begin) {
+        pop_scope(*block_local_begin);
+    }
+}
+
+void ValueNumbering::pop_scope(std::uint32_t scope_size) {
+    while (m_inserted_slots.size() > scope_size) {
+        m_table[m_inserted_slots.take_last()].inst = nullptr;
+    }
+}
+
+unsigned ValueNumbering::run(Function *function, const DominanceInfo &dom_info) {
+    if (function->blocks().empty()) {
+        // No body, e.g. an abstract or external method.
+        return 0;
+    }
+    std::uint32_t inst_count = 0;
+    for (auto *block : function->blocks()) {
+        for ([[maybe_unused]] auto *inst : *block) {
+            inst_count++;
+        }
+    }
+    ensure_capacity(inst_count);
+    m_replaced_count = 0;
+
+    // Preorder walk of the dominator tree, so that every block sees the values computed by its dominators.
+    struct Frame {
+        BasicBlock *block;
+        unsigned child_index;
+        std::uint32_t scope_size;
+    };
+    Vector<Frame> stack;
+    auto enter = [&](BasicBlock *block) {
+        stack.push(Frame{block, 0, m_inserted_slots.size()});
+        number_block(block);
+    };
+    enter(function->entry_block());
+    while (!stack.empty()) {
+        auto &frame = stack.last();
+        const auto &children = dom_info.children(frame.block);
+        if (frame.child_index < children.size()) {
+            enter(children[frame.child_index++]);
+            continue;
+        }
+
+        // Forget the values which are only available in this subtree.
+        pop_scope(frame.scope_size);
+        stack.pop();
+    }
+    return m_replaced_count;
+}
+
+} // namespace codespy::ir